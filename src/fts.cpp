@@ -21,13 +21,17 @@
 //SOFTWARE.
 
 #include "fts.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
 
 fts::SpinLock::SpinLock()
 : m_isLocked(false) {}
 
 
 fts::AdaptiveLock::AdaptiveLock()
-: m_address(0) {}
+: m_state(AdaptiveLock::unlocked) {}
 
 
 fts::SpinSemaphore::SpinSemaphore()
@@ -37,27 +41,655 @@ fts::SpinSemaphore::SpinSemaphore(int32_t max)
 
 
 fts::AdaptiveSemaphore::AdaptiveSemaphore()
-: m_counter(1), m_address(0) {}
+: m_state(AdaptiveSemaphore::permitBias + 1) {}
 fts::AdaptiveSemaphore::AdaptiveSemaphore(int32_t max)
-: m_counter(max), m_address(0) {}
+: m_state(AdaptiveSemaphore::permitBias + static_cast<uint64_t>(max)) {}
 
 
-fts::Signal::Signal()
-: m_address(0), m_numWaiting(0)
-#ifdef FTS_PLATFORM_UNKNOWN
-, m_mutex(), m_unlocked(false)
-#endif
+fts::LightweightSemaphore::LightweightSemaphore()
+: m_count(1), m_sleepers(0) {}
+fts::LightweightSemaphore::LightweightSemaphore(int32_t max)
+: m_count(max), m_sleepers(0) {}
+
+
+fts::FairSemaphore::FairSemaphore()
+: m_lock(), m_permits(1), m_waiters() {}
+fts::FairSemaphore::FairSemaphore(int32_t max)
+: m_lock(), m_permits(max), m_waiters() {}
+
+
+fts::WeightedSemaphore::WeightedSemaphore(int64_t max)
+: m_lock(), m_permits(max), m_capacity(max), m_waiters() {}
+
+
+fts::ShardedSemaphore::ShardedSemaphore(int32_t max, uint32_t numShards)
+: m_shards(), m_numShards(numShards != 0 ? numShards : std::max(1u, std::thread::hardware_concurrency())), m_batchSize(1), m_transferLock(),
+m_pool(max), m_epoch(0), m_numWaiting(0)
 {
-	#ifdef FTS_PLATFORM_UNKNOWN
-	m_mutex.lock();
-	#endif
+	//half the permits fit in the shards at once so there is always some left to steal or refill from
+	this->m_batchSize = std::max(1, max / static_cast<int32_t>(2 * this->m_numShards));
+	this->m_shards = std::make_unique<Shard[]>(this->m_numShards);
+	for(uint32_t i = 0; i < this->m_numShards; i++) this->m_shards[i].permits.store(0, std::memory_order_relaxed);
 }
 
+
+fts::RateLimiter::RateLimiter(double tokensPerSecond, int64_t burst, uint32_t numShards)
+: m_buckets(), m_numBuckets(std::max(numShards, 1u)), m_interval(1e9 / tokensPerSecond * std::max(numShards, 1u)),
+m_tolerance(static_cast<int64_t>(static_cast<double>(burst) * 1e9 / tokensPerSecond))
+{
+	this->m_buckets = std::make_unique<Bucket[]>(this->m_numBuckets);
+	for(uint32_t i = 0; i < this->m_numBuckets; i++) this->m_buckets[i].theoreticalArrival.store(0, std::memory_order_relaxed);
+}
+
+
+fts::Signal::Signal()
+: m_pendingWakes(0), m_numWaiting(0) {}
+
 fts::SpinSignal::SpinSignal()
 : m_isWaiting(false) {}
 
+fts::ConditionVariable::ConditionVariable()
+: m_sequence(0), m_numWaiters(0), m_lockWord(nullptr) {}
+
+fts::AutoResetEvent::AutoResetEvent(bool isSet)
+: m_state(isSet ? AutoResetEvent::setBit : 0) {}
+
+fts::ManualResetEvent::ManualResetEvent(bool isSet)
+: m_state(isSet ? ManualResetEvent::setBit : 0) {}
+
 fts::Flag::Flag()
-: m_isRaised(false) {}
+: m_state(0) {}
+
+fts::EventCount::EventCount()
+: m_state(0) {}
+
+fts::Latch::Latch(int32_t count)
+: m_state(std::max(count, 0) * Latch::countIncrement) {}
+
+fts::WaitGroup::WaitGroup()
+: m_state(0) {}
+
+fts::Phaser::Phaser(uint32_t parties, Phaser* parent)
+: m_state(0), m_parent(parent), m_root(parent != nullptr ? parent->m_root : this), m_registrationLock()
+{
+	assert(parties <= Phaser::maxParties);
+	if(parties == 0) this->m_state.store(makeState(parent != nullptr ? parent->phase() : 0, 0), std::memory_order_relaxed);
+	else this->m_state.store(makeState(parent != nullptr ? parent->registerParty() : 0, parties), std::memory_order_relaxed);
+}
+
+fts::Barrier::Barrier(uint32_t numThreads, BarrierAlgorithm algorithm, std::function<void()> completion)
+: m_algorithm(algorithm), m_numThreads(std::max(numThreads, 1u)), m_numRounds(0), m_completion(std::move(completion)), m_phase(), m_nodes(), m_flags(), m_participants()
+{
+	this->m_phase.value.store(0, std::memory_order_relaxed);
+	this->m_participants = std::make_unique<Participant[]>(this->m_numThreads);
+	if(algorithm == BarrierAlgorithm::Dissemination)
+	{
+		while((uint64_t(1) << this->m_numRounds) < this->m_numThreads) this->m_numRounds++;
+		this->m_flags = std::make_unique<PhaseFlag[]>(this->m_numThreads * this->m_numRounds);
+		for(uint32_t i = 0; i < this->m_numThreads * this->m_numRounds; i++) this->m_flags[i].value.store(0, std::memory_order_relaxed);
+		return;
+	}
+
+	//levels are stored leaves first, the sense reversing barrier is a single leaf that every thread arrives at
+	auto leafArrivals = algorithm == BarrierAlgorithm::SenseReversing ? this->m_numThreads : treeArity;
+	uint32_t numNodes = 0;
+	for(auto levelSize = (this->m_numThreads + leafArrivals - 1) / leafArrivals; ; levelSize = (levelSize + treeArity - 1) / treeArity)
+	{
+		numNodes += levelSize;
+		if(levelSize == 1) break;
+	}
+	this->m_nodes = std::make_unique<Node[]>(numNodes);
+
+	uint32_t levelStart = 0;
+	auto numChildren = this->m_numThreads;
+	auto arrivals = leafArrivals;
+	while(true)
+	{
+		auto levelSize = (numChildren + arrivals - 1) / arrivals;
+		for(uint32_t i = 0; i < levelSize; i++)
+		{
+			auto& node = this->m_nodes[levelStart + i];
+			node.numArrivals = static_cast<int32_t>(std::min(arrivals, numChildren - i * arrivals));
+			node.count.store(node.numArrivals, std::memory_order_relaxed);
+			node.release.value.store(0, std::memory_order_relaxed);
+			node.parent = levelSize == 1 ? noParent : levelStart + levelSize + i / treeArity;
+		}
+		if(levelSize == 1) break;
+		levelStart += levelSize;
+		numChildren = levelSize;
+		arrivals = treeArity;
+	}
+}
+
+//platform: linux
+#ifdef FTS_PLATFORM_LINUX
+	namespace
+	{
+		int makeEventfd(int flags)
+		{
+			int fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK | flags);
+			if(fd < 0) throw std::system_error(errno, std::system_category(), "eventfd");
+			return fd;
+		}
+	}
+
+	fts::PollableSignal::PollableSignal()
+	: m_state(0), m_fd(makeEventfd(0)) {}
+	fts::PollableSignal::~PollableSignal()
+	{
+		close(this->m_fd);
+	}
+
+	fts::PollableSemaphore::PollableSemaphore()
+	: m_count(1), m_fd(makeEventfd(EFD_SEMAPHORE)) {}
+	fts::PollableSemaphore::PollableSemaphore(int32_t max)
+	: m_count(max), m_fd(makeEventfd(EFD_SEMAPHORE)) {}
+	fts::PollableSemaphore::~PollableSemaphore()
+	{
+		close(this->m_fd);
+	}
+
+	void fts::detail::eventfdWrite(int fd, uint64_t value)
+	{
+		while(write(fd, &value, sizeof(value)) < 0 && errno == EINTR);
+	}
+	uint64_t fts::detail::eventfdRead(int fd)
+	{
+		uint64_t value = 0;
+		while(read(fd, &value, sizeof(value)) < 0)
+		{
+			if(errno != EINTR) return 0;
+		}
+		return value;
+	}
+	void fts::detail::pollIn(int fd)
+	{
+		pollfd entry{fd, POLLIN, 0};
+		while(poll(&entry, 1, -1) < 0 && errno == EINTR);
+	}
+#endif
+
+fts::SNZI::SNZI()
+: SNZI(std::thread::hardware_concurrency()) {}
+fts::SNZI::SNZI(uint32_t numLeaves)
+: m_root(0), m_nodes(), m_firstLeaf(0), m_numLeaves(fanout)
+{
+	//complete tree with fanout children per node, the children of the root are the first level
+	uint32_t numNodes = fanout;
+	while(this->m_numLeaves < numLeaves)
+	{
+		this->m_firstLeaf = numNodes;
+		this->m_numLeaves *= fanout;
+		numNodes += this->m_numLeaves;
+	}
+	this->m_nodes = std::make_unique<Node[]>(numNodes);
+	for(uint32_t i = 0; i < numNodes; i++)
+	{
+		this->m_nodes[i].state.store(0, std::memory_order_relaxed);
+		this->m_nodes[i].parent = i < fanout ? rootIndex : (i / fanout) - 1;
+	}
+}
+
+fts::detail::ReadIndicator::ReadIndicator()
+: m_counters(), m_numCounters(std::max(1u, std::thread::hardware_concurrency()))
+{
+	this->m_counters = std::make_unique<Counter[]>(this->m_numCounters);
+	for(uint32_t i = 0; i < this->m_numCounters; i++) this->m_counters[i].count.store(0, std::memory_order_relaxed);
+}
+
+namespace
+{
+	//trivially destructible so a domain destroyed after the thread's records, such as a static one, can still check it
+	thread_local bool areThreadRecordsDestroyed = false;
+}
+
+void fts::detail::ThreadRecords::add(void* owner, void* record, ReleaseFunction release)
+{
+	this->m_entries.push_back(Entry{owner, record, release});
+}
+
+void fts::detail::ThreadRecords::remove(const void* owner)
+{
+	if(areThreadRecordsDestroyed) return;
+	std::erase_if(threadRecords().m_entries, [owner](const Entry& entry){ return entry.owner == owner; });
+}
+
+fts::detail::ThreadRecords::~ThreadRecords()
+{
+	for(auto& entry : this->m_entries) entry.release(entry.owner, entry.record);
+	areThreadRecordsDestroyed = true;
+}
+
+fts::AdaptiveWaitPolicy::Waiters::Waiters()
+: m_numSleeping(0) {}
+
+fts::UpgradeableRWLock::UpgradeableRWLock()
+: m_state(0) {}
+
+fts::OptLock::OptLock()
+: m_version(0) {}
+
+
+namespace
+{
+	//global rcu state, the registry of reader threads and the reclaimer thread that runs call_rcu callbacks
+	class RcuState
+	{
+		public:
+			std::mutex gracePeriodMutex;
+			//only ever grows so registering never waits for a grace period in progress
+			std::atomic<fts::rcu::detail::ThreadRecord*> readers = nullptr;
+
+			std::mutex callbackMutex;
+			std::condition_variable callbackCondition;
+			std::vector<std::function<void()>> callbacks;
+			uint64_t numQueued = 0;
+			uint64_t numCompleted = 0;
+			bool isStopping = false;
+			std::thread reclaimer;
+
+			void startReclaimer()
+			{
+				if(!this->reclaimer.joinable()) this->reclaimer = std::thread(&RcuState::reclaim, this);
+			}
+
+			~RcuState()
+			{
+				{
+					std::lock_guard<std::mutex> lock(this->callbackMutex);
+					this->isStopping = true;
+				}
+				this->callbackCondition.notify_all();
+				if(this->reclaimer.joinable()) this->reclaimer.join();
+			}
+
+		private:
+			void reclaim()
+			{
+				std::vector<std::function<void()>> batch;
+				std::unique_lock<std::mutex> lock(this->callbackMutex);
+				while(true)
+				{
+					this->callbackCondition.wait(lock, [this](){ return this->isStopping || !this->callbacks.empty(); });
+					if(this->callbacks.empty()) return;
+
+					//everything queued so far shares one grace period
+					batch.swap(this->callbacks);
+					lock.unlock();
+					fts::rcu::synchronize();
+					for(auto& callback : batch) callback();
+					auto numRun = batch.size();
+					batch.clear();
+					lock.lock();
+
+					this->numCompleted += numRun;
+					this->callbackCondition.notify_all();
+				}
+			}
+	};
+
+	RcuState& rcuState()
+	{
+		static RcuState state;
+		return state;
+	}
+
+	bool isOldReader(const fts::rcu::detail::ThreadRecord* record)
+	{
+		auto counter = record->counter.load(std::memory_order_relaxed);
+		return (counter & fts::rcu::detail::nestMask) != 0 && ((counter ^ fts::rcu::detail::globalCounter.load(std::memory_order_relaxed)) & fts::rcu::detail::phase) != 0;
+	}
 
-fts::ReadWriteLock::ReadWriteLock()
-: m_numReaders(0), m_writeRequest(false) {}
\ No newline at end of file
+	//flips the phase and waits for every reader that started in the old phase to finish
+	void flipPhaseAndWait(RcuState& state)
+	{
+		//seq_cst pairs with a registering thread's fence, a record missed here belongs to a reader that sees the new phase
+		fts::rcu::detail::globalCounter.fetch_xor(fts::rcu::detail::phase, std::memory_order_seq_cst);
+		for(auto record = state.readers.load(std::memory_order_seq_cst); record != nullptr; record = record->next)
+		{
+			for(uint32_t attempt = 0; isOldReader(record); attempt++)
+			{
+				if(attempt < 128) fts::detail::cpuRelax();
+				else if(attempt < 256) std::this_thread::yield();
+				else std::this_thread::sleep_for(std::chrono::microseconds(100));
+			}
+		}
+	}
+}
+
+fts::rcu::detail::ThreadRegistration::ThreadRegistration()
+: record(nullptr)
+{
+	//lock free so a thread's first read lock never waits behind synchronize(), a released record is reused first
+	auto& state = rcuState();
+	for(auto current = state.readers.load(std::memory_order_acquire); current != nullptr; current = current->next)
+	{
+		bool isActive = false;
+		if(!current->isActive.load(std::memory_order_relaxed) && current->isActive.compare_exchange_strong(isActive, true, std::memory_order_acquire, std::memory_order_relaxed))
+		{
+			this->record = current;
+			return;
+		}
+	}
+	this->record = new ThreadRecord();
+	this->record->counter.store(0, std::memory_order_relaxed);
+	this->record->isActive.store(true, std::memory_order_relaxed);
+	this->record->next = state.readers.load(std::memory_order_relaxed);
+	while(!state.readers.compare_exchange_weak(this->record->next, this->record, std::memory_order_seq_cst, std::memory_order_relaxed));
+	//pairs with the phase flip in synchronize(), either it sees this record or this thread's first read sees the new phase
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+fts::rcu::detail::ThreadRegistration::~ThreadRegistration()
+{
+	//the thread is outside any critical section so its counter is already zero
+	this->record->isActive.store(false, std::memory_order_release);
+}
+
+void fts::rcu::synchronize()
+{
+	auto& state = rcuState();
+	std::lock_guard<std::mutex> gracePeriodLock(state.gracePeriodMutex);
+	if(state.readers.load(std::memory_order_acquire) == nullptr) return;
+
+	//orders the updater's earlier writes before reading the readers' counters, pairs with the readers' light fences
+	fts::detail::asymmetricHeavyFence();
+	//two flips so a reader that read the phase just before the first flip is also waited for
+	flipPhaseAndWait(state);
+	flipPhaseAndWait(state);
+	//orders the finished critical sections before whatever the updater does next, usually freeing memory
+	fts::detail::asymmetricHeavyFence();
+}
+void fts::rcu::call_rcu(std::function<void()> callback)
+{
+	auto& state = rcuState();
+	{
+		std::lock_guard<std::mutex> lock(state.callbackMutex);
+		state.startReclaimer();
+		state.callbacks.push_back(std::move(callback));
+		state.numQueued++;
+	}
+	state.callbackCondition.notify_all();
+}
+void fts::rcu::barrier()
+{
+	auto& state = rcuState();
+	std::unique_lock<std::mutex> lock(state.callbackMutex);
+	auto target = state.numQueued;
+	state.callbackCondition.wait(lock, [&state, target](){ return state.numCompleted >= target; });
+}
+fts::HazardPointerDomain::HazardPointerDomain()
+: m_records(nullptr), m_numRecords(0) {}
+
+fts::HazardPointerDomain::~HazardPointerDomain()
+{
+	detail::ThreadRecords::remove(this);
+	auto record = this->m_records.load(std::memory_order_acquire);
+	while(record != nullptr)
+	{
+		for(auto& [pointer, deleter] : record->retired) deleter();
+		auto next = record->next;
+		delete record;
+		record = next;
+	}
+}
+
+void fts::HazardPointerDomain::reclaim()
+{
+	this->scan(this->threadRecord());
+}
+
+fts::detail::HazardRecord& fts::HazardPointerDomain::acquireRecord()
+{
+	//records are never freed while the domain is alive, a thread reuses a released one before adding another
+	detail::HazardRecord* record = nullptr;
+	for(auto current = this->m_records.load(std::memory_order_acquire); current != nullptr; current = current->next)
+	{
+		bool isActive = false;
+		if(!current->isActive.load(std::memory_order_relaxed) && current->isActive.compare_exchange_strong(isActive, true, std::memory_order_acquire, std::memory_order_relaxed))
+		{
+			record = current;
+			break;
+		}
+	}
+	if(record == nullptr)
+	{
+		record = new detail::HazardRecord();
+		for(auto& hazard : record->hazards) hazard.store(nullptr, std::memory_order_relaxed);
+		record->isActive.store(true, std::memory_order_relaxed);
+		record->next = this->m_records.load(std::memory_order_relaxed);
+		while(!this->m_records.compare_exchange_weak(record->next, record, std::memory_order_release, std::memory_order_relaxed));
+		this->m_numRecords.fetch_add(1, std::memory_order_relaxed);
+	}
+	detail::threadRecords().add(this, record, &HazardPointerDomain::releaseRecord);
+	return *record;
+}
+
+void fts::HazardPointerDomain::releaseRecord(void* domain, void* threadRecord)
+{
+	auto& record = *static_cast<detail::HazardRecord*>(threadRecord);
+	for(auto& hazard : record.hazards) hazard.store(nullptr, std::memory_order_release);
+	//anything still protected elsewhere stays on the record for its next owner or the domain destructor
+	if(!record.retired.empty()) static_cast<HazardPointerDomain*>(domain)->scan(record);
+	record.isActive.store(false, std::memory_order_release);
+}
+
+void fts::HazardPointerDomain::scan(detail::HazardRecord& record)
+{
+	//pairs with the light fence in protect(), every hazard published before this point is now visible
+	detail::asymmetricHeavyFence();
+
+	std::vector<void*> hazards;
+	hazards.reserve(HazardPointerDomain::numSlots * this->m_numRecords.load(std::memory_order_relaxed));
+	for(auto current = this->m_records.load(std::memory_order_acquire); current != nullptr; current = current->next)
+	{
+		for(auto& hazard : current->hazards)
+		{
+			auto pointer = hazard.load(std::memory_order_acquire);
+			if(pointer != nullptr) hazards.push_back(pointer);
+		}
+	}
+	std::sort(hazards.begin(), hazards.end());
+
+	auto isProtected = [&hazards](const auto& retired){ return std::binary_search(hazards.begin(), hazards.end(), retired.first); };
+	auto firstFree = std::partition(record.retired.begin(), record.retired.end(), isProtected);
+	//move the deleters out first so a deleter that retires more objects does not modify the list being iterated
+	std::vector<std::pair<void*, std::function<void()>>> reclaimable(std::make_move_iterator(firstFree), std::make_move_iterator(record.retired.end()));
+	record.retired.erase(firstFree, record.retired.end());
+	for(auto& [pointer, deleter] : reclaimable) deleter();
+}
+
+fts::HazardPointerDomain& fts::defaultHazardPointerDomain()
+{
+	static HazardPointerDomain domain;
+	return domain;
+}
+
+fts::EpochDomain::EpochDomain()
+: m_epoch(0), m_records(nullptr) {}
+
+fts::EpochDomain::~EpochDomain()
+{
+	detail::ThreadRecords::remove(this);
+	auto record = this->m_records.load(std::memory_order_acquire);
+	while(record != nullptr)
+	{
+		for(uint32_t i = 0; i < 3; i++) EpochDomain::freeLimbo(*record, i);
+		auto next = record->next;
+		delete record;
+		record = next;
+	}
+}
+
+void fts::EpochDomain::reclaim()
+{
+	this->reclaim(this->threadRecord());
+}
+
+fts::detail::EpochRecord& fts::EpochDomain::acquireRecord()
+{
+	detail::EpochRecord* record = nullptr;
+	for(auto current = this->m_records.load(std::memory_order_acquire); current != nullptr; current = current->next)
+	{
+		bool isActive = false;
+		if(!current->isActive.load(std::memory_order_relaxed) && current->isActive.compare_exchange_strong(isActive, true, std::memory_order_acquire, std::memory_order_relaxed))
+		{
+			record = current;
+			break;
+		}
+	}
+	if(record == nullptr)
+	{
+		record = new detail::EpochRecord();
+		record->announcement.store(0, std::memory_order_relaxed);
+		record->nesting = 0;
+		record->isActive.store(true, std::memory_order_relaxed);
+		for(auto& limboEpoch : record->limboEpochs) limboEpoch = 0;
+		record->numRetired = 0;
+		record->next = this->m_records.load(std::memory_order_relaxed);
+		while(!this->m_records.compare_exchange_weak(record->next, record, std::memory_order_release, std::memory_order_relaxed));
+	}
+	detail::threadRecords().add(this, record, &EpochDomain::releaseRecord);
+	return *record;
+}
+
+void fts::EpochDomain::releaseRecord(void* domain, void* threadRecord)
+{
+	auto& record = *static_cast<detail::EpochRecord*>(threadRecord);
+	record.nesting = 0;
+	record.announcement.store(0, std::memory_order_release);
+	//whatever is not yet safe stays on the record for its next owner or the domain destructor
+	static_cast<EpochDomain*>(domain)->reclaim(record);
+	record.isActive.store(false, std::memory_order_release);
+}
+
+bool fts::EpochDomain::tryAdvance()
+{
+	auto epoch = this->m_epoch.load(std::memory_order_seq_cst);
+	//pairs with the light fence in enter(), every announcement made before this point is now visible
+	detail::asymmetricHeavyFence();
+	for(auto current = this->m_records.load(std::memory_order_acquire); current != nullptr; current = current->next)
+	{
+		auto announcement = current->announcement.load(std::memory_order_acquire);
+		if((announcement & detail::EpochRecord::active) != 0 && (announcement >> 1) != epoch) return false;
+	}
+	//losing the race means another thread advanced it, which is just as good
+	this->m_epoch.compare_exchange_strong(epoch, epoch + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+	return true;
+}
+
+void fts::EpochDomain::reclaim(detail::EpochRecord& record)
+{
+	record.numRetired = 0;
+	this->tryAdvance();
+	auto epoch = this->m_epoch.load(std::memory_order_seq_cst);
+	for(uint32_t i = 0; i < 3; i++)
+	{
+		if(record.limboEpochs[i] + 2 <= epoch) EpochDomain::freeLimbo(record, i);
+	}
+}
+
+void fts::EpochDomain::freeLimbo(detail::EpochRecord& record, uint32_t index)
+{
+	//move the list out first so a deleter that retires more objects does not modify the list being iterated
+	auto limbo = std::move(record.limbo[index]);
+	record.limbo[index].clear();
+	for(auto& deleter : limbo) deleter();
+}
+
+namespace
+{
+	constexpr size_t maxWaitAnySources = 128;
+
+	#ifdef FTS_PLATFORM_LINUX
+		//struct futex_waitv, declared here since older kernel headers do not have it
+		struct FutexWaitv
+		{
+			uint64_t value;
+			uint64_t address;
+			uint32_t flags;
+			uint32_t reserved;
+		};
+		#ifdef SYS_futex_waitv
+			constexpr long futexWaitvSyscall = SYS_futex_waitv;
+		#else
+			constexpr long futexWaitvSyscall = 449;
+		#endif
+		constexpr uint32_t futexSize32 = 2;
+		//cleared the first time the kernel turns out not to have futex_waitv
+		std::atomic_bool hasFutexWaitv(true);
+	#endif
+
+	//registers with each source until one is already ready, returns how many were registered
+	size_t armAll(const fts::detail::WaitAnySource* sources, size_t numSources, int32_t* expected)
+	{
+		for(size_t i = 0; i < numSources; i++)
+		{
+			if(!sources[i].armWait(sources[i].object, expected[i])) return i;
+		}
+		return numSources;
+	}
+	void disarmAll(const fts::detail::WaitAnySource* sources, size_t numArmed)
+	{
+		for(size_t i = 0; i < numArmed; i++) sources[i].disarmWait(sources[i].object);
+	}
+}
+
+size_t fts::detail::waitAny(const WaitAnySource* sources, size_t numSources)
+{
+	int32_t expected[maxWaitAnySources];
+	while(true)
+	{
+		for(int32_t attempt = 0; attempt < detail::adaptiveSpinCount; attempt++)
+		{
+			for(size_t i = 0; i < numSources; i++)
+			{
+				if(sources[i].tryWait(sources[i].object)) return i;
+			}
+			detail::cpuRelax();
+		}
+
+		//platform: linux
+		#ifdef FTS_PLATFORM_LINUX
+			if(hasFutexWaitv.load(std::memory_order_relaxed)) [[likely]]
+			{
+				auto numArmed = armAll(sources, numSources, expected);
+				if(numArmed == numSources)
+				{
+					FutexWaitv waiters[maxWaitAnySources];
+					for(size_t i = 0; i < numSources; i++)
+					{
+						waiters[i] = FutexWaitv{static_cast<uint32_t>(expected[i]), reinterpret_cast<uintptr_t>(sources[i].futexWord(sources[i].object)), futexSize32 | FUTEX_PRIVATE_FLAG, 0};
+					}
+					//a changed word or a signal is retried, any other failure such as ENOSYS would fail the same way every
+					//time and spin, so the event count takes over for good
+					if(syscall(futexWaitvSyscall, waiters, numSources, 0, nullptr, 0) < 0 && errno != EAGAIN && errno != EINTR)
+					{
+						hasFutexWaitv.store(false, std::memory_order_relaxed);
+					}
+				}
+				disarmAll(sources, numArmed);
+				continue;
+			}
+		#endif
+
+		//no futex_waitv, register with every source so their wakes notify the shared event count and sleep on that
+		detail::waitAnyFallbackUsers.fetch_add(1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		auto numArmed = armAll(sources, numSources, expected);
+		auto ready = numSources;
+		if(numArmed == numSources)
+		{
+			auto& eventCount = detail::waitAnyEventCount();
+			auto key = eventCount.prepareWait();
+			for(size_t i = 0; i < numSources && ready == numSources; i++)
+			{
+				if(sources[i].tryWait(sources[i].object)) ready = i;
+			}
+			if(ready == numSources) eventCount.commitWait(key);
+			else eventCount.cancelWait();
+		}
+		disarmAll(sources, numArmed);
+		detail::waitAnyFallbackUsers.fetch_sub(1, std::memory_order_relaxed);
+		if(ready != numSources) return ready;
+	}
+}
@@ -46,14 +46,26 @@
 #endif
 
 
+#include <algorithm>
 #include <atomic>
-#ifdef FTS_PLATFORM_UNKNOWN
-	#include <mutex>
-#endif
+#include <bit>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <new>
+#include <system_error>
+#include <type_traits>
+#include <vector>
 #ifdef FTS_PLATFORM_LINUX
 	#include <unistd.h>
 	#include <sys/syscall.h>
 	#include <linux/futex.h>
+	#include <linux/membarrier.h>
+	#include <poll.h>
+	#include <sys/eventfd.h>
 #endif
 #ifdef FTS_PLATFORM_WINDOWS
 	#include <windows.h>
@@ -67,9 +79,100 @@
 #define FTS_SEMAPHORE_DESTORY_COUNTER_LOCKGUARD(l) fts::SemaphoreDestoryCounterLockGuard ftsMacroSemaphoreDestoryCounterLockGuardInstance(l);
 #define FTS_READ_WRITE_READ_LOCKGUARD(l) fts::ReadWriteLockReadLockGuard ftsMacroReadWriteLockReadLockGuardInstance(l);
 #define FTS_READ_WRITE_WRITE_LOCKGUARD(l) fts::ReadWriteLockWriteLockGuard ftsMacroReadWriteLockWriteLockGuardInstance(l);
+#define FTS_UPGRADEABLE_READ_LOCKGUARD(l) fts::UpgradeableRWLockReadLockGuard ftsMacroUpgradeableRWLockReadLockGuardInstance(l);
+#define FTS_UPGRADEABLE_WRITE_LOCKGUARD(l) fts::UpgradeableRWLockWriteLockGuard ftsMacroUpgradeableRWLockWriteLockGuardInstance(l);
+#define FTS_UPGRADEABLE_UPGRADE_LOCKGUARD(l) fts::UpgradeableRWLockUpgradeLockGuard ftsMacroUpgradeableRWLockUpgradeLockGuardInstance(l);
 
 namespace fts
 {
+	namespace detail
+	{
+		//number of times adaptive primitives poll before going to sleep
+		constexpr int32_t adaptiveSpinCount = 128;
+
+		inline void cpuRelax();
+		inline void futexWait(std::atomic_int32_t* address, int32_t expected);
+		//returns false once the timeout has passed, may also return early like futexWait
+		inline bool futexWaitFor(std::atomic_int32_t* address, int32_t expected, std::chrono::nanoseconds timeout);
+		//now() + timeout saturated at time_point::max(), which the timed waits treat as waiting for ever
+		inline std::chrono::steady_clock::time_point deadlineAfter(std::chrono::nanoseconds timeout);
+		inline void futexWake(std::atomic_int32_t* address, int32_t count);
+		//spins on word until isDone(value) holds, then sets waiterBit in it and sleeps until the waker sees the bit. Returns
+		//false once the deadline has passed, time_point::max() waits for ever
+		template<typename DoneT>
+		inline bool waitOnWord(std::atomic_int32_t* word, int32_t waiterBit, DoneT isDone, std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max());
+		//the halves of a 64 bit word as futex words, so a futex can sleep on part of a word that also holds other state
+		inline std::atomic_int32_t* lowHalf(std::atomic_uint64_t& word);
+		inline std::atomic_int32_t* highHalf(std::atomic_uint64_t& word);
+
+		//small dense index unique to the calling thread, used to spread threads over per thread state
+		inline uint32_t threadIndex();
+
+		//asymmetric fences, when the heavy side can interrupt every thread of the process (membarrier) the light side only
+		//has to stop the compiler reordering, otherwise both are full fences
+		inline bool hasAsymmetricFences();
+		inline void asymmetricLightFence();
+		inline void asymmetricHeavyFence();
+
+		struct Empty {};
+
+		//lets waitAny() fall back to an EventCount, called by primitives waking a registered waiter
+		inline void notifyWaitAny();
+
+		//a waiting thread's queue entry, lives on the waiter's stack and is woken through its own futex word so waking
+		//one thread never disturbs the others
+		struct ParkingNode
+		{
+			inline void park();
+			//the node may be gone as soon as this returns
+			inline void unpark();
+
+			std::atomic_int32_t isUnparked = 0;
+			ParkingNode* next = nullptr;
+			//how much the waiter is waiting for, for queues where waiters want different amounts
+			int64_t amount = 1;
+		};
+
+		//first in first out list of parked waiters, only touched under the owning primitive's lock
+		struct ParkingQueue
+		{
+			inline void push(ParkingNode& node);
+			//unlinks waiters from the front for as long as fits(node) holds and returns them as a list for unparkAll()
+			template<typename FitsT>
+			inline ParkingNode* detachWhile(FitsT fits);
+			//wakes a detached list, called after dropping the lock
+			static inline void unparkAll(ParkingNode* nodes);
+
+			ParkingNode* head = nullptr;
+			ParkingNode* tail = nullptr;
+		};
+
+		//readers counter striped over cache lines by thread so arriving and departing are a single uncontended fetch_add
+		class ReadIndicator
+		{
+			public:
+				inline void arrive();
+				inline void depart();
+				inline bool isEmpty() const;
+
+				ReadIndicator();
+				ReadIndicator(const ReadIndicator&) = delete;
+				ReadIndicator(ReadIndicator&&) = delete;
+
+				ReadIndicator& operator=(const ReadIndicator&) = delete;
+				ReadIndicator& operator=(ReadIndicator&&) = delete;
+
+			private:
+				struct alignas(64) Counter
+				{
+					std::atomic_int32_t count;
+				};
+
+				std::unique_ptr<Counter[]> m_counters;
+				uint32_t m_numCounters;
+		};
+	}
+
 	class SpinLock
 	{
 		public:
@@ -87,6 +190,8 @@ namespace fts
 		private:
 			std::atomic_bool m_isLocked;
 	};
+	//futex mutex (Drepper, futexes are tricky), the word is 0 unlocked, 1 locked and 2 locked with possible waiters so
+	//unlock only enters the kernel when a thread may be sleeping
 	class AdaptiveLock
 	{
 		public:
@@ -94,6 +199,11 @@ namespace fts
 			inline void unlock();
 			inline bool try_lock();
 
+			//ConditionVariable hooks, lockContended() locks as if other threads were waiting so that unlocking passes the
+			//lock on to the threads requeued onto futexWord()
+			inline std::atomic_int32_t* futexWord();
+			inline void lockContended();
+
 			AdaptiveLock();
 			AdaptiveLock(const AdaptiveLock&) = delete;
 			AdaptiveLock(AdaptiveLock&&) = delete;
@@ -102,10 +212,11 @@ namespace fts
 			AdaptiveLock& operator=(AdaptiveLock&&) = delete;
 		
 		private:
-			int32_t m_address;
-			#ifdef FTS_PLATFORM_UNKNOWN
-			std::mutex m_mutex;
-			#endif
+			static constexpr int32_t unlocked = 0;
+			static constexpr int32_t locked = 1;
+			static constexpr int32_t contended = 2;
+
+			std::atomic_int32_t m_state;
 	};
 	class SpinSemaphore
 	{
@@ -132,6 +243,8 @@ namespace fts
 		private:
 			std::atomic_int32_t m_counter;
 	};
+	//permits and waiters share one word, permits in the half the futex sleeps on, so a release only enters the kernel when
+	//someone has registered as waiting and a waiter can never miss the release that happened before it went to sleep
 	class AdaptiveSemaphore
 	{
 		public:
@@ -139,9 +252,23 @@ namespace fts
 			inline void unlock();
 			inline bool try_lock();
 
+			//takes or returns n permits at once with a single atomic operation
+			inline void acquire(int32_t n = 1);
+			inline void release(int32_t n = 1);
+			inline bool tryAcquire(int32_t n = 1);
+			//takes one permit, for waitAny()
+			inline bool tryWait();
+			//waitAny() hooks, armWait() registers as a waiter and gives the futex word's value to sleep on, or returns false
+			//when already ready
+			inline std::atomic_int32_t* futexWord();
+			inline bool armWait(int32_t& expected);
+			inline void disarmWait();
+
+			//the permit is not returned so there is nobody to wake
 			inline void unlockDestoryCounter();
 
 			inline void addCounter(int32_t n = 1);
+			//never waits, the count may go negative and acquire() waits until releases bring it back above zero
 			inline void removeCounter(int32_t n = 1);
 
 			inline int32_t numCounters() const;
@@ -155,11 +282,197 @@ namespace fts
 			AdaptiveSemaphore& operator=(AdaptiveSemaphore&&) = delete;
 		
 		private:
-			std::atomic_int32_t m_counter;
-			int32_t m_address;
-			#ifdef FTS_PLATFORM_UNKNOWN
-			std::mutex m_mutex;
-			#endif
+			//permits in the low half, registered waiters in the high half and a flag set once any waiter wants more than
+			//one permit, then a release has to wake every waiter since it cannot tell which of them fit. The permits are
+			//stored offset by permitBias so the count can go negative without borrowing from the waiters
+			static constexpr uint64_t permitMask = 0x7FFFFFFF;
+			static constexpr uint64_t permitBias = uint64_t(1) << 30;
+			static constexpr uint64_t waiterIncrement = uint64_t(1) << 32;
+			static constexpr uint64_t waiterMask = uint64_t(0x7FFFFFFF) << 32;
+			static constexpr uint64_t mixedWaiters = uint64_t(1) << 63;
+
+			std::atomic_uint64_t m_state;
+	};
+
+	//semaphore with a signed count (moodycamel), a negative count is the number of sleeping waiters. Waiting spins briefly
+	//and a release only touches the inner semaphore when the count was negative, so a producer and consumer that keep up
+	//with each other never enter the kernel
+	class LightweightSemaphore
+	{
+		public:
+			inline void lock();
+			inline void unlock();
+			inline bool try_lock();
+
+			inline void acquire();
+			inline void release(int32_t n = 1);
+			inline bool tryAcquire();
+
+			inline int32_t numCounters() const;
+
+			LightweightSemaphore();
+			LightweightSemaphore(int32_t max);
+			LightweightSemaphore(const LightweightSemaphore&) = delete;
+			LightweightSemaphore(LightweightSemaphore&&) = delete;
+
+			LightweightSemaphore& operator=(const LightweightSemaphore&) = delete;
+			LightweightSemaphore& operator=(LightweightSemaphore&&) = delete;
+		
+		private:
+			std::atomic_int32_t m_count;
+			AdaptiveSemaphore m_sleepers;
+	};
+
+	//permits are handed to waiters in the order they arrived, a release gives its permit straight to the oldest waiter
+	//instead of putting it back for whoever gets there first so nobody can barge in and nobody starves
+	class FairSemaphore
+	{
+		public:
+			inline void lock();
+			inline void unlock();
+			inline bool try_lock();
+
+			inline void acquire();
+			inline void release(int32_t n = 1);
+			inline bool tryAcquire();
+
+			inline int32_t numCounters() const;
+
+			FairSemaphore();
+			FairSemaphore(int32_t max);
+			FairSemaphore(const FairSemaphore&) = delete;
+			FairSemaphore(FairSemaphore&&) = delete;
+
+			FairSemaphore& operator=(const FairSemaphore&) = delete;
+			FairSemaphore& operator=(FairSemaphore&&) = delete;
+		
+		private:
+			SpinLock m_lock;
+			//only written while holding m_lock, atomic so numCounters() can read it without
+			std::atomic_int32_t m_permits;
+			detail::ParkingQueue m_waiters;
+	};
+
+	//a semaphore for reservations of different sizes such as a memory budget in bytes. acquire(n) waits for all n permits
+	//at once in arrival order, a large request at the head is never overtaken by a stream of smaller ones and a release
+	//wakes every waiter at the head that now fits in one pass
+	class WeightedSemaphore
+	{
+		public:
+			inline void lock();
+			inline void unlock();
+			inline bool try_lock();
+
+			//n has to be between 0 and the capacity the semaphore was created with
+			inline void acquire(int64_t n);
+			inline void release(int64_t n);
+			//returns false for requests larger than the capacity
+			inline bool tryAcquire(int64_t n);
+
+			inline int64_t numCounters() const;
+
+			WeightedSemaphore(int64_t max);
+			WeightedSemaphore(const WeightedSemaphore&) = delete;
+			WeightedSemaphore(WeightedSemaphore&&) = delete;
+
+			WeightedSemaphore& operator=(const WeightedSemaphore&) = delete;
+			WeightedSemaphore& operator=(WeightedSemaphore&&) = delete;
+		
+		private:
+			SpinLock m_lock;
+			//only written while holding m_lock, atomic so numCounters() can read it without
+			std::atomic_int64_t m_permits;
+			//what the semaphore was created with, a request for more could never be granted
+			int64_t m_capacity;
+			detail::ParkingQueue m_waiters;
+	};
+
+	//permits split over per thread shards so acquiring and releasing normally only touch the calling thread's cache line.
+	//A thread whose shard is empty refills it with a batch from the central pool or steals half of another shard, permits
+	//only move between shards under the transfer lock so the total stays exact
+	class ShardedSemaphore
+	{
+		public:
+			inline void lock();
+			inline void unlock();
+			inline bool try_lock();
+
+			inline void acquire();
+			inline void release(int32_t n = 1);
+			inline bool tryAcquire();
+
+			//relaxed sum of the shards, may be off while other threads acquire, release or move permits
+			inline int32_t numCounters() const;
+			//takes the transfer lock so no permits are in flight between shards
+			inline int32_t numCountersExact();
+
+			ShardedSemaphore(int32_t max, uint32_t numShards = 0);
+			ShardedSemaphore(const ShardedSemaphore&) = delete;
+			ShardedSemaphore(ShardedSemaphore&&) = delete;
+
+			ShardedSemaphore& operator=(const ShardedSemaphore&) = delete;
+			ShardedSemaphore& operator=(ShardedSemaphore&&) = delete;
+		
+		private:
+			struct alignas(64) Shard
+			{
+				std::atomic_int32_t permits;
+			};
+
+			inline Shard& threadShard();
+			//takes one permit for the caller and refills its shard, false when there are no permits anywhere
+			inline bool refill(Shard& shard);
+
+			std::unique_ptr<Shard[]> m_shards;
+			uint32_t m_numShards;
+			int32_t m_batchSize;
+			SpinLock m_transferLock;
+			//only written while holding m_transferLock
+			alignas(64) std::atomic_int32_t m_pool;
+			//waiters sleep on the epoch, a release bumps it only when someone is waiting
+			alignas(64) std::atomic_int32_t m_epoch;
+			std::atomic_int32_t m_numWaiting;
+	};
+
+	//token bucket rate limiter kept as a virtual time (GCRA), each bucket is the time at which it would be full again so
+	//refilling is lazy and taking tokens is a single CAS. With more than one shard each thread uses its own bucket with an
+	//equal part of the rate and burst, so the burst should be at least the number of shards
+	class RateLimiter
+	{
+		public:
+			using Clock = std::chrono::steady_clock;
+
+			//waits until n tokens have accrued, n may be larger than the burst
+			inline void acquire(int64_t n = 1);
+			inline bool tryAcquire(int64_t n = 1);
+			//waits for n tokens if they will have accrued by the deadline, otherwise returns false straight away
+			inline bool tryAcquireUntil(int64_t n, Clock::time_point deadline);
+
+			RateLimiter(double tokensPerSecond, int64_t burst, uint32_t numShards = 1);
+			RateLimiter(const RateLimiter&) = delete;
+			RateLimiter(RateLimiter&&) = delete;
+
+			RateLimiter& operator=(const RateLimiter&) = delete;
+			RateLimiter& operator=(RateLimiter&&) = delete;
+		
+		private:
+			struct alignas(64) Bucket
+			{
+				//nanoseconds on Clock
+				std::atomic_int64_t theoreticalArrival;
+			};
+
+			//takes n tokens from bucket if they have accrued by deadline, readyAt is when they accrue
+			inline bool reserve(Bucket& bucket, int64_t n, int64_t now, int64_t deadline, int64_t& readyAt);
+			inline Bucket& threadBucket();
+			static inline int64_t now();
+
+			std::unique_ptr<Bucket[]> m_buckets;
+			uint32_t m_numBuckets;
+			//nanoseconds per token of one bucket
+			double m_interval;
+			//how far ahead of now a bucket's virtual time may run, the burst in nanoseconds
+			int64_t m_tolerance;
 	};
 
 	class Signal
@@ -179,12 +492,10 @@ namespace fts
 			Signal& operator=(Signal&&) = delete;
 		
 		private:
-			int32_t m_address;
+			//wakes handed to waiting threads that they have not picked up yet, the futex word, so a wake that comes before
+			//the waiter is asleep is not lost and a waiter never returns without one
+			std::atomic_int32_t m_pendingWakes;
 			std::atomic_int32_t m_numWaiting;
-			#ifdef FTS_PLATFORM_UNKNOWN
-			std::mutex m_mutex;
-			std::atomic_bool m_unlocked;
-			#endif
 	};
 	class SpinSignal
 	{
@@ -206,13 +517,127 @@ namespace fts
 			std::atomic_char m_isWaiting;
 	};
 
+	//condition variable for AdaptiveLock and other futex backed locks. Waiters sleep on a sequence number and notifyAll()
+	//wakes one of them and requeues the rest onto the lock's futex word (FUTEX_CMP_REQUEUE), so they are woken one at a
+	//time as the lock is passed on instead of all piling onto it. Locks without the futexWord() and lockContended() hooks
+	//have every waiter woken. The lock must be held to wait and every waiter must use the same lock
+	class ConditionVariable
+	{
+		public:
+			inline void notifyOne();
+			inline void notifyAll();
+
+			template<typename LockT>
+			inline void wait(LockT& lock);
+			template<typename LockT, typename PredicateT>
+			inline void wait(LockT& lock, PredicateT predicate);
+			//return false once the timeout has passed
+			template<typename LockT>
+			inline bool waitFor(LockT& lock, std::chrono::nanoseconds timeout);
+			template<typename LockT>
+			inline bool waitUntil(LockT& lock, std::chrono::steady_clock::time_point deadline);
+			//return the predicate's result, false only when the timeout passed without it becoming true
+			template<typename LockT, typename PredicateT>
+			inline bool waitFor(LockT& lock, std::chrono::nanoseconds timeout, PredicateT predicate);
+			template<typename LockT, typename PredicateT>
+			inline bool waitUntil(LockT& lock, std::chrono::steady_clock::time_point deadline, PredicateT predicate);
+
+			ConditionVariable();
+			ConditionVariable(const ConditionVariable&) = delete;
+			ConditionVariable(ConditionVariable&&) = delete;
+
+			ConditionVariable& operator=(const ConditionVariable&) = delete;
+			ConditionVariable& operator=(ConditionVariable&&) = delete;
+
+		private:
+			//the futex word, bumped by every notify so a notify between unlocking and sleeping is not lost
+			std::atomic_int32_t m_sequence;
+			//lets notifies skip the syscall when nobody waits
+			std::atomic_int32_t m_numWaiters;
+			//futex word of the waiters' lock, null when it has none
+			std::atomic<std::atomic_int32_t*> m_lockWord;
+	};
+
+	//event that lets exactly one waiter through per set() and then resets itself. A set() with nobody waiting is kept until
+	//the next wait()
+	class AutoResetEvent
+	{
+		public:
+			inline void set();
+			inline void reset();
+			inline void wait();
+			inline bool tryWait();
+			//waitAny() hooks
+			inline std::atomic_int32_t* futexWord();
+			inline bool armWait(int32_t& expected);
+			inline void disarmWait();
+
+			inline bool isSet() const;
+
+			AutoResetEvent(bool isSet = false);
+			AutoResetEvent(const AutoResetEvent&) = delete;
+			AutoResetEvent(AutoResetEvent&&) = delete;
+
+			AutoResetEvent& operator=(const AutoResetEvent&) = delete;
+			AutoResetEvent& operator=(AutoResetEvent&&) = delete;
+		
+		private:
+			//set bit and the number of registered waiters above it
+			static constexpr int32_t setBit = 1;
+			static constexpr int32_t waiterIncrement = 2;
+
+			std::atomic_int32_t m_state;
+	};
+	//event that lets every waiter through while it is set, until reset()
+	class ManualResetEvent
+	{
+		public:
+			inline void set();
+			inline void reset();
+			inline void wait();
+			//only checks, a manual reset event stays set for other waiters
+			inline bool tryWait();
+			//waitAny() hooks
+			inline std::atomic_int32_t* futexWord();
+			inline bool armWait(int32_t& expected);
+			inline void disarmWait();
+
+			inline bool isSet() const;
+
+			ManualResetEvent(bool isSet = false);
+			ManualResetEvent(const ManualResetEvent&) = delete;
+			ManualResetEvent(ManualResetEvent&&) = delete;
+
+			ManualResetEvent& operator=(const ManualResetEvent&) = delete;
+			ManualResetEvent& operator=(ManualResetEvent&&) = delete;
+		
+		private:
+			static constexpr int32_t setBit = 1;
+			static constexpr int32_t waiterBit = 2;
+
+			std::atomic_int32_t m_state;
+	};
+
 	class Flag
 	{
 		public:
+			//only call into the kernel when a thread is waiting for the change
 			inline void raise();
 			inline void lower();
 			inline bool isRaised();
 
+			inline void waitRaised();
+			inline void waitLowered();
+			//return whether the flag reached the state before the timeout
+			inline bool waitRaisedFor(std::chrono::nanoseconds timeout);
+			inline bool waitLoweredFor(std::chrono::nanoseconds timeout);
+			//waitAny() waits for the flag to be raised and does not lower it
+			inline bool tryWait();
+			//waitAny() hooks
+			inline std::atomic_int32_t* futexWord();
+			inline bool armWait(int32_t& expected);
+			inline void disarmWait();
+
 			Flag();
 			Flag(const Flag&) = delete;
 			Flag(Flag&&) = delete;
@@ -221,33 +646,862 @@ namespace fts
 			Flag& operator=(Flag&&) = delete;
 		
 		private:
-			std::atomic_bool m_isRaised;
+			//raised bit and a bit set by threads sleeping until the flag changes
+			static constexpr int32_t raisedBit = 1;
+			static constexpr int32_t waiterBit = 2;
+
+			inline bool waitUntil(int32_t wanted, std::chrono::steady_clock::time_point deadline);
+
+			std::atomic_int32_t m_state;
 	};
 
-	class ReadWriteLock
+	//event count (folly). Lets a thread sleep until a condition on some other lock free state becomes true without losing
+	//the wakeup, check the condition, prepareWait(), check it again and only then commitWait(). A notify between the two
+	//checks moves the epoch on so commitWait() returns straight away. notify() only calls into the kernel when some thread
+	//has prepared to wait
+	class EventCount
+	{
+		public:
+			class Key
+			{
+				private:
+					friend class EventCount;
+					inline explicit Key(uint32_t epoch);
+					uint32_t m_epoch;
+			};
+
+			inline void notify();
+			inline void notifyAll();
+
+			inline Key prepareWait();
+			inline void cancelWait();
+			inline void commitWait(Key key);
+
+			//waits until condition() returns true, it is checked before sleeping after every notify
+			template<typename ConditionT>
+			inline void await(ConditionT&& condition);
+
+			EventCount();
+			EventCount(const EventCount&) = delete;
+			EventCount(EventCount&&) = delete;
+
+			EventCount& operator=(const EventCount&) = delete;
+			EventCount& operator=(EventCount&&) = delete;
+		
+		private:
+			//registered waiters in the low half and the epoch in the high half, which is the half the futex sleeps on
+			static constexpr uint64_t waiterIncrement = 1;
+			static constexpr uint64_t waiterMask = 0xFFFFFFFF;
+			static constexpr int32_t epochShift = 32;
+			static constexpr uint64_t epochIncrement = uint64_t(1) << epochShift;
+
+			inline void notify(int32_t n);
+
+			std::atomic_uint64_t m_state;
+	};
+
+	enum class BarrierAlgorithm
+	{
+		//one shared counter, the last thread to arrive releases the others. Best for small teams
+		SenseReversing,
+		//threads arrive on a tree of padded counters with four arrivals each, only the last arrival at a node goes on up.
+		//The team is released back down the same tree so no flag is waited on by more than four threads
+		CombiningTree,
+		//log2(n) rounds in which every thread sets the padded flag of a different partner, nothing is shared by the team
+		Dissemination
+	};
+
+	//reusable barrier for a fixed team of threads. Each thread passes its own index below the team size, no two threads
+	//share an index, which picks its counter in the tree and its flags in the dissemination barrier. Waits spin briefly
+	//and then sleep on a futex. The completion function runs once per phase on one thread after everyone has arrived and
+	//before anyone leaves
+	class Barrier
+	{
+		public:
+			inline void arriveAndWait(uint32_t threadIndex);
+			inline uint32_t numThreads() const;
+
+			Barrier(uint32_t numThreads, BarrierAlgorithm algorithm = BarrierAlgorithm::SenseReversing, std::function<void()> completion = {});
+			Barrier(const Barrier&) = delete;
+			Barrier(Barrier&&) = delete;
+
+			Barrier& operator=(const Barrier&) = delete;
+			Barrier& operator=(Barrier&&) = delete;
+
+		private:
+			//phase number shifted up by one and a sleeping bit. The phase only moves forwards so it takes the place of the
+			//sense and a flag that has already moved past the phase being waited for still counts as reached
+			struct alignas(64) PhaseFlag
+			{
+				std::atomic_int32_t value;
+			};
+			struct alignas(64) Node
+			{
+				std::atomic_int32_t count;
+				int32_t numArrivals;
+				uint32_t parent;
+				//the threads that stopped at this node wait here, the one that went on up releases them on its way back
+				PhaseFlag release;
+			};
+			//only touched by its own thread
+			struct alignas(64) Participant
+			{
+				uint32_t phase;
+			};
+
+			static constexpr int32_t sleepingBit = 1;
+			static constexpr uint32_t treeArity = 4;
+			static constexpr uint32_t noParent = std::numeric_limits<uint32_t>::max();
+			//a tree with four arrivals per node over any uint32_t sized team is at most 16 levels deep
+			static constexpr uint32_t maxTreeDepth = 16;
+
+			static inline bool hasReached(int32_t value, uint32_t phase);
+			static inline void waitForPhase(PhaseFlag& flag, uint32_t phase);
+			static inline void publishPhase(PhaseFlag& flag, uint32_t phase);
+			inline void arriveOnTree(uint32_t threadIndex);
+			inline void arriveDissemination(uint32_t threadIndex);
+			inline void complete(uint32_t phase);
+
+			BarrierAlgorithm m_algorithm;
+			uint32_t m_numThreads;
+			uint32_t m_numRounds;
+			std::function<void()> m_completion;
+			//phase the dissemination barrier releases the team with once the completion function has run
+			PhaseFlag m_phase;
+			std::unique_ptr<Node[]> m_nodes;
+			//dissemination flags, numRounds per thread
+			std::unique_ptr<PhaseFlag[]> m_flags;
+			std::unique_ptr<Participant[]> m_participants;
+	};
+
+	//single use countdown, wait() returns once count downs have taken the count to zero. The count and a waiter bit share
+	//the futex word so only the count down that reaches zero with threads asleep enters the kernel
+	class Latch
+	{
+		public:
+			inline void countDown(int32_t n = 1);
+			inline void wait();
+			inline bool tryWait() const;
+			inline void arriveAndWait(int32_t n = 1);
+
+			Latch(int32_t count);
+			Latch(const Latch&) = delete;
+			Latch(Latch&&) = delete;
+
+			Latch& operator=(const Latch&) = delete;
+			Latch& operator=(Latch&&) = delete;
+
+		private:
+			//count shifted up by one above the waiter bit
+			static constexpr int32_t waiterBit = 1;
+			static constexpr int32_t countIncrement = 2;
+
+			std::atomic_int32_t m_state;
+	};
+
+	//wait group (go). add() work before handing it out, done() when it is finished and wait() until nothing is left. It
+	//can be reused once the count is back at zero. Same word layout as Latch, only the done() that reaches zero with
+	//threads asleep enters the kernel
+	class WaitGroup
+	{
+		public:
+			inline void add(int32_t n = 1);
+			inline void done(int32_t n = 1);
+			inline void wait();
+			inline bool tryWait() const;
+
+			WaitGroup();
+			WaitGroup(const WaitGroup&) = delete;
+			WaitGroup(WaitGroup&&) = delete;
+
+			WaitGroup& operator=(const WaitGroup&) = delete;
+			WaitGroup& operator=(WaitGroup&&) = delete;
+
+		private:
+			static constexpr int32_t waiterBit = 1;
+			static constexpr int32_t countIncrement = 2;
+
+			std::atomic_int32_t m_state;
+	};
+
+	//phaser (java). A reusable barrier whose parties can register and deregister between and during phases. The phase,
+	//the number of parties and the number still to arrive are one 64 bit word, the phase and a waiter bit make up the
+	//high half that waiters sleep on. A phaser with a parent is a tier of a tree, it takes part in its parent as a single
+	//party while it has parties of its own and arrives there once all of them have, so a large team spreads its
+	//arrivals over the tree. The whole tree shares the root's phase and waiters sleep on the root
+	class Phaser
+	{
+		public:
+			//return the phase the new parties arrive in, a phaser holds at most 65535 parties
+			inline uint32_t registerParty();
+			inline uint32_t registerParties(uint32_t n);
+			//return the phase arrived in, only a registered party that has not arrived yet in this phase may arrive
+			inline uint32_t arrive();
+			inline uint32_t arriveAndDeregister();
+			inline uint32_t arriveAndAwaitAdvance();
+			//returns straight away if the phase has already moved on, returns the next phase
+			inline uint32_t awaitAdvance(uint32_t phase);
+
+			inline uint32_t phase() const;
+			inline uint32_t numParties() const;
+			inline uint32_t numUnarrived() const;
+			inline Phaser* parent() const;
+
+			Phaser(uint32_t parties = 0, Phaser* parent = nullptr);
+			Phaser(const Phaser&) = delete;
+			Phaser(Phaser&&) = delete;
+
+			Phaser& operator=(const Phaser&) = delete;
+			Phaser& operator=(Phaser&&) = delete;
+
+		private:
+			//unarrived in bits 0-15, parties in bits 16-31, phase in bits 32-62 and the waiter bit 63
+			static constexpr uint64_t countMask = 0xFFFF;
+			static constexpr uint32_t maxParties = 0xFFFF;
+			static constexpr int32_t partiesShift = 16;
+			static constexpr uint64_t partyIncrement = uint64_t(1) << partiesShift;
+			static constexpr int32_t phaseShift = 32;
+			static constexpr uint32_t phaseMask = 0x7FFFFFFF;
+			static constexpr uint64_t waiterBit = uint64_t(1) << 63;
+
+			static inline uint64_t makeState(uint32_t phase, uint32_t parties);
+			static inline uint32_t phaseOf(uint64_t state);
+			//a tier can be a phase ahead of the root, so a phase only counts as over once the root has moved past it
+			static inline bool hasAdvanced(uint32_t rootPhase, uint32_t phase);
+			inline uint32_t doArrive(bool isDeregistering);
+
+			std::atomic_uint64_t m_state;
+			Phaser* m_parent;
+			Phaser* m_root;
+			//serialises a tier going from no parties to some, which registers it with its parent
+			SpinLock m_registrationLock;
+	};
+
+	//single assignment slot for passing one result between threads, a promise and future without the shared state. The
+	//value lives inline so nothing is allocated and readiness is a futex word, set() only enters the kernel when a thread
+	//is asleep in get(). A continuation registered with then() runs exactly once with the value, on the thread calling
+	//set() before readers can see the value or straight away in then() if the value is already there. Readers may destroy
+	//the slot once they have the value but a continuation run by set() must not. Only the first set() and the first
+	//then() take effect, later calls return false
+	template<typename T>
+	class OneShot
+	{
+		public:
+			using Continuation = void (*)(T& value, void* context);
+
+			//returns false without constructing anything if a value was already set
+			template<typename... Args>
+			inline bool set(Args&&... args);
+			inline T& get();
+			//returns nullptr while no value has been set
+			inline T* tryGet();
+			//returns false if the timeout passed before the value was set
+			inline bool waitFor(std::chrono::nanoseconds timeout);
+			inline bool isReady() const;
+			//returns false without registering if a continuation was already registered
+			inline bool then(Continuation continuation, void* context);
+
+			OneShot();
+			~OneShot();
+			OneShot(const OneShot&) = delete;
+			OneShot(OneShot&&) = delete;
+
+			OneShot& operator=(const OneShot&) = delete;
+			OneShot& operator=(OneShot&&) = delete;
+
+		private:
+			static constexpr int32_t readyBit = 1;
+			static constexpr int32_t waiterBit = 2;
+			static constexpr int32_t continuationBit = 4;
+			//claimed by the first set() before it constructs the value
+			static constexpr int32_t settingBit = 8;
+			//claimed by the first then() before it writes the continuation
+			static constexpr int32_t registeringBit = 16;
+
+			inline T* value();
+			inline bool waitUntil(std::chrono::steady_clock::time_point deadline);
+
+			std::atomic_int32_t m_state;
+			Continuation m_continuation;
+			void* m_context;
+			alignas(T) unsigned char m_storage[sizeof(T)];
+	};
+
+	//platform: linux, eventfd only exists on linux
+	#ifdef FTS_PLATFORM_LINUX
+		namespace detail
+		{
+			void eventfdWrite(int fd, uint64_t value);
+			//returns 0 instead of blocking when the eventfd is empty
+			uint64_t eventfdRead(int fd);
+			//blocks until fd is readable
+			void pollIn(int fd);
+		}
+
+		//signal that an epoll or io_uring loop can wait on through fd(), an eventfd. The loop calls prepareWait() before
+		//it blocks and wake() only writes to the eventfd when the loop has announced it is about to sleep, so wakes while
+		//the loop is busy never make a syscall. Wakes do not add up and one thread consumes them
+		class PollableSignal
+		{
+			public:
+				inline void wake();
+				//consumes a pending wake, call it every time the loop wakes up after prepareWait() as it also drains fd()
+				inline bool tryWait();
+				//blocks in poll() on fd()
+				inline void wait();
+
+				//announces the loop is about to sleep on fd(), returns false if a wake is already pending and it should not block
+				inline bool prepareWait();
+				inline int fd() const;
+
+				PollableSignal();
+				~PollableSignal();
+				PollableSignal(const PollableSignal&) = delete;
+				PollableSignal(PollableSignal&&) = delete;
+
+				PollableSignal& operator=(const PollableSignal&) = delete;
+				PollableSignal& operator=(PollableSignal&&) = delete;
+
+			private:
+				static constexpr int32_t wokenBit = 1;
+				static constexpr int32_t sleepingBit = 2;
+
+				std::atomic_int32_t m_state;
+				int m_fd;
+		};
+
+		//counting semaphore that an epoll or io_uring loop can wait on through fd(), an eventfd in semaphore mode. Permits
+		//are counted in user space and a negative count is the number of consumers that announced they are about to sleep,
+		//release() only writes to the eventfd for those so releases while every consumer is busy never make a syscall
+		class PollableSemaphore
+		{
+			public:
+				inline void acquire();
+				inline bool tryAcquire();
+				inline void release(int32_t n = 1);
+
+				//takes a permit or announces the caller is about to sleep on fd(), returns false when it took a permit and
+				//should not block. Otherwise the caller must finishWait() once fd() is readable or cancelWait()
+				inline bool prepareWait();
+				//takes the permit a release() handed over through fd(), returns false if another consumer got it first
+				inline bool finishWait();
+				//withdraws from prepareWait(), returns true if a permit had already been handed over and the caller now holds it
+				inline bool cancelWait();
+				inline int fd() const;
+
+				PollableSemaphore();
+				PollableSemaphore(int32_t max);
+				~PollableSemaphore();
+				PollableSemaphore(const PollableSemaphore&) = delete;
+				PollableSemaphore(PollableSemaphore&&) = delete;
+
+				PollableSemaphore& operator=(const PollableSemaphore&) = delete;
+				PollableSemaphore& operator=(PollableSemaphore&&) = delete;
+
+			private:
+				std::atomic_int32_t m_count;
+				int m_fd;
+		};
+	#endif
+
+	namespace detail
+	{
+		//type erased waitAny() hooks of one primitive
+		struct WaitAnySource
+		{
+			void* object;
+			bool (*tryWait)(void* object);
+			std::atomic_int32_t* (*futexWord)(void* object);
+			bool (*armWait)(void* object, int32_t& expected);
+			void (*disarmWait)(void* object);
+		};
+		size_t waitAny(const WaitAnySource* sources, size_t numSources);
+
+		//number of threads in waitAny() using the EventCount fallback, primitives only notify it while this is non zero
+		inline std::atomic_int32_t waitAnyFallbackUsers(0);
+		inline EventCount& waitAnyEventCount();
+	}
+
+	//waits until any of the primitives is ready and returns its index, semaphores and auto reset events are consumed while
+	//flags and manual reset events are only checked. Sleeps on every futex word at once with futex_waitv on Linux 5.16+,
+	//otherwise on a shared EventCount that the primitives notify whenever waitAny() has registered with them
+	template<typename... WaitableT>
+	inline size_t waitAny(WaitableT&... waitables);
+
+	//scalable non zero indicator (Ellen, Lev, Luchangco & Moir). Threads arrive and depart at a leaf of a tree of counters
+	//and only a leaf going between zero and non zero is passed up, so the root word changes rarely and query() reads just it
+	class SNZI
+	{
+		public:
+			inline void arrive();
+			inline void depart();
+			inline bool query() const;
+
+			//the root word, zero exactly when query() is false. Can be waited on
+			inline std::atomic_int32_t& indicator();
+
+			SNZI();
+			explicit SNZI(uint32_t numLeaves);
+			SNZI(const SNZI&) = delete;
+			SNZI(SNZI&&) = delete;
+
+			SNZI& operator=(const SNZI&) = delete;
+			SNZI& operator=(SNZI&&) = delete;
+		
+		private:
+			static constexpr uint32_t fanout = 4;
+			static constexpr uint32_t rootIndex = std::numeric_limits<uint32_t>::max();
+			//a node's low 32 bits are the encoded count (0 = zero, 1 = half, n + 1 = n), the high 32 bits the version
+			static constexpr uint64_t countMask = 0xFFFFFFFF;
+			static constexpr uint64_t half = 1;
+			static constexpr uint64_t one = 2;
+			static constexpr uint64_t version = uint64_t(1) << 32;
+
+			struct alignas(64) Node
+			{
+				std::atomic_uint64_t state;
+				uint32_t parent;
+			};
+
+			inline void arrive(uint32_t node);
+			inline void depart(uint32_t node);
+
+			alignas(64) std::atomic_int32_t m_root;
+			std::unique_ptr<Node[]> m_nodes;
+			uint32_t m_firstLeaf;
+			uint32_t m_numLeaves;
+	};
+
+	//preference policies for BasicReadWriteLock
+	//readers may enter while a writer is waiting, writers only get in once there are no readers
+	struct ReaderPreference {};
+	//a waiting writer blocks new readers and only waits for the current readers to leave
+	struct WriterPreference {};
+	//alternates read and write phases so readers and writers wait at most one phase of the other kind
+	struct PhaseFairPreference {};
+
+	//reader tracking policies for BasicReadWriteLock
+	//readers are counted in the lock word itself
+	struct CountedReaders {};
+	//readers arrive on an SNZI so they only write a shared cache line when their leaf becomes empty or non empty
+	struct SNZIReaders {};
+
+	//wait policies, Waiters is the state a lock needs to park its waiting threads
+	struct SpinWaitPolicy
+	{
+		class Waiters
+		{
+			public:
+				inline void wait(std::atomic_int32_t& address, int32_t value);
+				inline void wakeAll(std::atomic_int32_t& address);
+		};
+	};
+	struct AdaptiveWaitPolicy
+	{
+		class Waiters
+		{
+			public:
+				inline void wait(std::atomic_int32_t& address, int32_t value);
+				inline void wakeAll(std::atomic_int32_t& address);
+
+				Waiters();
+				Waiters(const Waiters&) = delete;
+				Waiters(Waiters&&) = delete;
+
+				Waiters& operator=(const Waiters&) = delete;
+				Waiters& operator=(Waiters&&) = delete;
+
+			private:
+				std::atomic_int32_t m_numSleeping;
+		};
+	};
+
+	template<typename Preference, typename WaitPolicy = SpinWaitPolicy, typename ReaderTracking = CountedReaders>
+	class BasicReadWriteLock
+	{
+		public:
+			inline void readLock();
+			inline void writeLock();
+			inline void readUnlock();
+			inline void writeUnlock();
+			inline bool readTryLock();
+			inline bool writeTryLock();
+
+			inline BasicReadWriteLock();
+			BasicReadWriteLock(const BasicReadWriteLock&) = delete;
+			BasicReadWriteLock(BasicReadWriteLock&&) = delete;
+
+			BasicReadWriteLock& operator=(const BasicReadWriteLock&) = delete;
+			BasicReadWriteLock& operator=(BasicReadWriteLock&&) = delete;
+		
+		private:
+			static_assert(std::is_same_v<Preference, ReaderPreference> || std::is_same_v<Preference, WriterPreference>, "unknown read write lock preference");
+			static_assert(std::is_same_v<ReaderTracking, CountedReaders> || std::is_same_v<ReaderTracking, SNZIReaders>, "unknown read write lock reader tracking");
+			static constexpr bool usesSNZI = std::is_same_v<ReaderTracking, SNZIReaders>;
+
+			inline bool enterRead();
+			inline void waitForReaders();
+
+			//writer bit and readers count share one word so a reader can never slip in between a writer's request and its reader check
+			//with SNZIReaders the word only holds the writer bit
+			static constexpr int32_t writer = 0x1;
+			static constexpr int32_t reader = 0x2;
+
+			std::atomic_int32_t m_state;
+			[[no_unique_address]] typename WaitPolicy::Waiters m_waiters;
+			[[no_unique_address]] std::conditional_t<usesSNZI, SNZI, detail::Empty> m_readers;
+	};
+	template<typename WaitPolicy, typename ReaderTracking>
+	class BasicReadWriteLock<PhaseFairPreference, WaitPolicy, ReaderTracking>
+	{
+		public:
+			inline void readLock();
+			inline void writeLock();
+			inline void readUnlock();
+			inline void writeUnlock();
+			inline bool readTryLock();
+			inline bool writeTryLock();
+
+			inline BasicReadWriteLock();
+			BasicReadWriteLock(const BasicReadWriteLock&) = delete;
+			BasicReadWriteLock(BasicReadWriteLock&&) = delete;
+
+			BasicReadWriteLock& operator=(const BasicReadWriteLock&) = delete;
+			BasicReadWriteLock& operator=(BasicReadWriteLock&&) = delete;
+		
+		private:
+			static_assert(std::is_same_v<ReaderTracking, CountedReaders>, "phase fair readers are counted by their tickets");
+
+			//ticket based phase fair lock (Brandenburg & Anderson). The low byte of m_readersIn holds the writer present and phase bits, readers count in units of 0x100
+			static constexpr int32_t readerIncrement = 0x100;
+			static constexpr int32_t writerBits = 0x3;
+			static constexpr int32_t writerPresent = 0x2;
+			static constexpr int32_t writerPhase = 0x1;
+
+			std::atomic_int32_t m_readersIn;
+			std::atomic_int32_t m_readersOut;
+			std::atomic_int32_t m_writersIn;
+			std::atomic_int32_t m_writersOut;
+			[[no_unique_address]] typename WaitPolicy::Waiters m_waiters;
+	};
+
+	using ReadWriteLock = BasicReadWriteLock<WriterPreference, SpinWaitPolicy>;
+	using PhaseFairRWLock = BasicReadWriteLock<PhaseFairPreference, SpinWaitPolicy>;
+	class UpgradeableRWLock
 	{
 		public:
 			inline void readLock();
 			inline void writeLock();
+			inline void upgradeLock();
 			inline void readUnlock();
 			inline void writeUnlock();
+			inline void upgradeUnlock();
 			inline bool readTryLock();
 			inline bool writeTryLock();
+			inline bool upgradeTryLock();
+
+			//upgrade lock -> write lock without letting another writer in between
+			inline void upgrade();
+			//write lock -> upgrade lock, readers may enter again straight away
+			inline void downgrade();
+
+			UpgradeableRWLock();
+			UpgradeableRWLock(const UpgradeableRWLock&) = delete;
+			UpgradeableRWLock(UpgradeableRWLock&&) = delete;
+
+			UpgradeableRWLock& operator=(const UpgradeableRWLock&) = delete;
+			UpgradeableRWLock& operator=(UpgradeableRWLock&&) = delete;
+		
+		private:
+			//one upgrader may coexist with readers, writers and upgraders exclude each other. Readers count in units of reader
+			static constexpr int32_t writer = 0x1;
+			static constexpr int32_t upgrader = 0x2;
+			static constexpr int32_t reader = 0x4;
+
+			std::atomic_int32_t m_state;
+	};
+	//version lock for optimistic lock coupling (Leis et al, ART and LeanStore). Readers remember the version and validate it
+	//after reading instead of writing to the lock, writers take the lock bit and bump the version when they release it
+	class OptLock
+	{
+		public:
+			inline uint64_t readLockOrRestart(bool& needRestart) const;
+			inline void checkOrRestart(uint64_t version, bool& needRestart) const;
+			inline void readUnlockOrRestart(uint64_t version, bool& needRestart) const;
+			inline void upgradeToWriteLockOrRestart(uint64_t& version, bool& needRestart);
+			inline void writeLockOrRestart(bool& needRestart);
+			inline void writeUnlock();
+			//unlock and mark the protected node as removed so every reader holding an old version restarts
+			inline void writeUnlockObsolete();
 
-			ReadWriteLock();
-			ReadWriteLock(const ReadWriteLock&) = delete;
-			ReadWriteLock(ReadWriteLock&&) = delete;
+			inline bool isLocked() const;
 
-			ReadWriteLock& operator=(const ReadWriteLock&) = delete;
-			ReadWriteLock& operator=(ReadWriteLock&&) = delete;
+			OptLock();
+			OptLock(const OptLock&) = delete;
+			OptLock(OptLock&&) = delete;
+
+			OptLock& operator=(const OptLock&) = delete;
+			OptLock& operator=(OptLock&&) = delete;
 		
 		private:
-			std::atomic_int32_t m_numReaders;
-			std::atomic_bool m_writeRequest;
+			static constexpr uint64_t obsolete = 0x1;
+			static constexpr uint64_t locked = 0x2;
+
+			std::atomic_uint64_t m_version;
+	};
+
+	//left right (Ramalhete & Correia). Keeps two copies of T, readers are wait free and always see a consistent copy while
+	//the writer changes the other one, then waits for the readers to move over before applying the same change again.
+	//The function passed to modify() is called once per copy so it must be deterministic
+	template<typename T>
+	class LeftRight
+	{
+		public:
+			template<typename ReaderT>
+			inline std::invoke_result_t<ReaderT, const T&> read(ReaderT&& reader) const;
+			template<typename WriterT>
+			inline void modify(WriterT&& writer);
+
+			template<typename... Args>
+			inline explicit LeftRight(const Args&... args);
+			LeftRight(const LeftRight<T>&) = delete;
+			LeftRight(LeftRight<T>&&) = delete;
+
+			LeftRight<T>& operator=(const LeftRight<T>&) = delete;
+			LeftRight<T>& operator=(LeftRight<T>&&) = delete;
+		
+		private:
+			inline void toggleVersionAndWait();
+
+			T m_instances[2];
+			std::atomic_int32_t m_leftRight;
+			std::atomic_int32_t m_versionIndex;
+			mutable detail::ReadIndicator m_readIndicators[2];
+			SpinLock m_writerLock;
 	};
 
+	//userspace RCU. Read side critical sections only write a thread local nesting counter, updaters wait for every
+	//critical section that was running to finish with synchronize() or defer the wait with call_rcu().
+	//synchronize() must never be called from inside a read side critical section
+	namespace rcu
+	{
+		inline void readLock();
+		inline void readUnlock();
+
+		void synchronize();
+		//runs the callback on the reclaimer thread after a grace period, callbacks are batched behind one synchronize()
+		void call_rcu(std::function<void()> callback);
+		//waits until every callback queued before the call has run
+		void barrier();
+
+		class ReadLockGuard
+		{
+			public:
+				inline ReadLockGuard();
+				ReadLockGuard(const ReadLockGuard&) = delete;
+				ReadLockGuard(ReadLockGuard&&) = delete;
+				inline ~ReadLockGuard();
+
+				ReadLockGuard& operator=(const ReadLockGuard&) = delete;
+				ReadLockGuard& operator=(ReadLockGuard&&) = delete;
+		};
+
+		namespace detail
+		{
+			//a reader's counter holds its nesting depth in the low half and the grace period phase it started in
+			constexpr uint64_t nestMask = 0xFFFFFFFF;
+			constexpr uint64_t phase = uint64_t(1) << 32;
+
+			//the low half is always 1 so a reader can copy it in one store when entering its outermost critical section
+			inline std::atomic_uint64_t globalCounter(1);
+
+			//records are never freed, a thread that exits leaves its record for the next thread to claim
+			struct alignas(64) ThreadRecord
+			{
+				std::atomic_uint64_t counter;
+				std::atomic_bool isActive;
+				ThreadRecord* next;
+			};
+			class ThreadRegistration
+			{
+				public:
+					ThreadRegistration();
+					ThreadRegistration(const ThreadRegistration&) = delete;
+					ThreadRegistration(ThreadRegistration&&) = delete;
+					~ThreadRegistration();
+
+					ThreadRegistration& operator=(const ThreadRegistration&) = delete;
+					ThreadRegistration& operator=(ThreadRegistration&&) = delete;
+
+					ThreadRecord* record;
+			};
+
+			inline ThreadRecord& threadRecord();
+		}
+	}
+
 
 
+	class HazardPointerDomain;
+	namespace detail
+	{
+		struct alignas(64) HazardRecord
+		{
+			static constexpr uint32_t numSlots = 8;
+
+			std::atomic<void*> hazards[numSlots];
+			std::atomic_bool isActive;
+			HazardRecord* next;
+			//only touched by the thread that owns the record
+			std::vector<std::pair<void*, std::function<void()>>> retired;
+		};
+		//the per thread records the calling thread owns in each reclamation domain it has used, released when the thread exits
+		class ThreadRecords
+		{
+			public:
+				using ReleaseFunction = void(*)(void* owner, void* record);
+
+				inline void* find(const void* owner) const;
+				void add(void* owner, void* record, ReleaseFunction release);
+				//forgets owner on the calling thread, safe to call after the thread's records were destroyed
+				static void remove(const void* owner);
+
+				ThreadRecords() = default;
+				ThreadRecords(const ThreadRecords&) = delete;
+				ThreadRecords(ThreadRecords&&) = delete;
+				~ThreadRecords();
+
+				ThreadRecords& operator=(const ThreadRecords&) = delete;
+				ThreadRecords& operator=(ThreadRecords&&) = delete;
+
+			private:
+				struct Entry
+				{
+					void* owner;
+					void* record;
+					ReleaseFunction release;
+				};
+
+				std::vector<Entry> m_entries;
+		};
+		inline ThreadRecords& threadRecords();
+	}
+
+	//hazard pointers (Michael). A reader publishes the pointer it is about to use in one of its slots and retired objects
+	//are only freed once no slot holds them. Retired objects are kept per thread and scanned in batches proportional to the
+	//number of slots, the scan sorts the published hazards so each retired pointer is a binary search.
+	//A domain must outlive every thread that used it, the destructor frees whatever is still retired
+	class HazardPointerDomain
+	{
+		public:
+			static constexpr uint32_t numSlots = detail::HazardRecord::numSlots;
+
+			//loads source and protects the result in slot, retrying until the pointer is still current once published
+			template<typename T>
+			inline T* protect(const std::atomic<T*>& source, uint32_t slot = 0);
+			inline void clear(uint32_t slot = 0);
+			inline void clearAll();
+			//the deleter is called with pointer once no thread protects it anymore
+			template<typename T, typename DeleterT = std::default_delete<T>>
+			inline void retire(T* pointer, DeleterT deleter = DeleterT());
+			//scans the calling thread's retired objects now instead of waiting for the batch to fill
+			void reclaim();
+
+			HazardPointerDomain();
+			HazardPointerDomain(const HazardPointerDomain&) = delete;
+			HazardPointerDomain(HazardPointerDomain&&) = delete;
+			~HazardPointerDomain();
+
+			HazardPointerDomain& operator=(const HazardPointerDomain&) = delete;
+			HazardPointerDomain& operator=(HazardPointerDomain&&) = delete;
+
+		private:
+			inline detail::HazardRecord& threadRecord();
+			detail::HazardRecord& acquireRecord();
+			static void releaseRecord(void* domain, void* record);
+			void scan(detail::HazardRecord& record);
+
+			std::atomic<detail::HazardRecord*> m_records;
+			std::atomic_uint32_t m_numRecords;
+	};
+
+	//domain shared by the whole process
+	HazardPointerDomain& defaultHazardPointerDomain();
+
+	namespace detail
+	{
+		struct alignas(64) EpochRecord
+		{
+			//a thread inside a guard announces (epoch << 1) | active
+			static constexpr uint64_t active = 1;
+
+			std::atomic_uint64_t announcement;
+			uint32_t nesting;
+			std::atomic_bool isActive;
+			EpochRecord* next;
+			//objects retired during limboEpochs[i], only touched by the thread that owns the record
+			std::vector<std::function<void()>> limbo[3];
+			uint64_t limboEpochs[3];
+			uint32_t numRetired;
+		};
+	}
+
+	//epoch based reclamation (Fraser). A guard pins the global epoch for a whole traversal, the epoch only advances once
+	//every pinned thread has seen the current one so objects retired two epochs ago can no longer be reached. Each thread
+	//keeps one limbo list per epoch in flight and frees a whole list at a time. Cheaper than hazard pointers per node but a
+	//thread stalled inside a guard stops all reclamation.
+	//A domain must outlive every thread that used it, the destructor frees whatever is still retired
+	class EpochDomain
+	{
+		public:
+			class Guard
+			{
+				public:
+					inline explicit Guard(EpochDomain& domain);
+					Guard(const Guard&) = delete;
+					Guard(Guard&&) = delete;
+					inline ~Guard();
+
+					Guard& operator=(const Guard&) = delete;
+					Guard& operator=(Guard&&) = delete;
+
+				private:
+					EpochDomain& m_domain;
+			};
+
+			inline Guard guard();
+			//guards nest, only the outermost enter() pins an epoch
+			inline void enter();
+			inline void exit();
+			//the deleter is called with pointer once every guard that could have reached it has exited
+			template<typename T, typename DeleterT = std::default_delete<T>>
+			inline void retire(T* pointer, DeleterT deleter = DeleterT());
+			//tries to advance the epoch and frees the calling thread's lists that became safe
+			void reclaim();
+
+			EpochDomain();
+			EpochDomain(const EpochDomain&) = delete;
+			EpochDomain(EpochDomain&&) = delete;
+			~EpochDomain();
+
+			EpochDomain& operator=(const EpochDomain&) = delete;
+			EpochDomain& operator=(EpochDomain&&) = delete;
+
+		private:
+			//number of retires between attempts to advance the epoch
+			static constexpr uint32_t advanceInterval = 64;
+
+			inline detail::EpochRecord& threadRecord();
+			detail::EpochRecord& acquireRecord();
+			static void releaseRecord(void* domain, void* record);
+			bool tryAdvance();
+			void reclaim(detail::EpochRecord& record);
+			static void freeLimbo(detail::EpochRecord& record, uint32_t index);
+
+			alignas(64) std::atomic_uint64_t m_epoch;
+			std::atomic<detail::EpochRecord*> m_records;
+	};
+
 	template<typename LockT>
 	class GenericLockGuard
 	{
@@ -280,33 +1534,84 @@ namespace fts
 			SemaphoreT* m_semaphore;
 	};
 
+	class UpgradeableRWLockReadLockGuard
+	{
+		public:
+			inline UpgradeableRWLockReadLockGuard(UpgradeableRWLock& upgradeableRWLock);
+			explicit inline UpgradeableRWLockReadLockGuard(UpgradeableRWLock* upgradeableRWLock);
+			UpgradeableRWLockReadLockGuard(const UpgradeableRWLockReadLockGuard&) = delete;
+			UpgradeableRWLockReadLockGuard(UpgradeableRWLockReadLockGuard&&) = delete;
+			inline ~UpgradeableRWLockReadLockGuard();
+
+			UpgradeableRWLockReadLockGuard& operator=(const UpgradeableRWLockReadLockGuard&) = delete;
+			UpgradeableRWLockReadLockGuard& operator=(UpgradeableRWLockReadLockGuard&&) = delete;
+		private:
+			UpgradeableRWLock* m_upgradeableRWLock;
+	};
+
+	class UpgradeableRWLockWriteLockGuard
+	{
+		public:
+			inline UpgradeableRWLockWriteLockGuard(UpgradeableRWLock& upgradeableRWLock);
+			explicit inline UpgradeableRWLockWriteLockGuard(UpgradeableRWLock* upgradeableRWLock);
+			UpgradeableRWLockWriteLockGuard(const UpgradeableRWLockWriteLockGuard&) = delete;
+			UpgradeableRWLockWriteLockGuard(UpgradeableRWLockWriteLockGuard&&) = delete;
+			inline ~UpgradeableRWLockWriteLockGuard();
+
+			UpgradeableRWLockWriteLockGuard& operator=(const UpgradeableRWLockWriteLockGuard&) = delete;
+			UpgradeableRWLockWriteLockGuard& operator=(UpgradeableRWLockWriteLockGuard&&) = delete;
+		private:
+			UpgradeableRWLock* m_upgradeableRWLock;
+	};
+
+	class UpgradeableRWLockUpgradeLockGuard
+	{
+		public:
+			inline UpgradeableRWLockUpgradeLockGuard(UpgradeableRWLock& upgradeableRWLock);
+			explicit inline UpgradeableRWLockUpgradeLockGuard(UpgradeableRWLock* upgradeableRWLock);
+			UpgradeableRWLockUpgradeLockGuard(const UpgradeableRWLockUpgradeLockGuard&) = delete;
+			UpgradeableRWLockUpgradeLockGuard(UpgradeableRWLockUpgradeLockGuard&&) = delete;
+			inline ~UpgradeableRWLockUpgradeLockGuard();
+
+			inline void upgrade();
+			inline void downgrade();
+
+			UpgradeableRWLockUpgradeLockGuard& operator=(const UpgradeableRWLockUpgradeLockGuard&) = delete;
+			UpgradeableRWLockUpgradeLockGuard& operator=(UpgradeableRWLockUpgradeLockGuard&&) = delete;
+		private:
+			UpgradeableRWLock* m_upgradeableRWLock;
+			bool m_isUpgraded;
+	};
+
+	template<typename ReadWriteLockT = ReadWriteLock>
 	class ReadWriteLockReadLockGuard
 	{
 		public:
-			inline ReadWriteLockReadLockGuard(ReadWriteLock& readWriteLock);
-			explicit inline ReadWriteLockReadLockGuard(ReadWriteLock* readWriteLock);
-			ReadWriteLockReadLockGuard(const ReadWriteLockReadLockGuard&) = delete;
-			ReadWriteLockReadLockGuard(ReadWriteLockReadLockGuard&&) = delete;
+			inline ReadWriteLockReadLockGuard(ReadWriteLockT& readWriteLock);
+			explicit inline ReadWriteLockReadLockGuard(ReadWriteLockT* readWriteLock);
+			ReadWriteLockReadLockGuard(const ReadWriteLockReadLockGuard<ReadWriteLockT>&) = delete;
+			ReadWriteLockReadLockGuard(ReadWriteLockReadLockGuard<ReadWriteLockT>&&) = delete;
 			inline ~ReadWriteLockReadLockGuard();
 
-			ReadWriteLockReadLockGuard& operator=(const ReadWriteLockReadLockGuard&) = delete;
-			ReadWriteLockReadLockGuard& operator=(ReadWriteLockReadLockGuard&&) = delete;
+			ReadWriteLockReadLockGuard<ReadWriteLockT>& operator=(const ReadWriteLockReadLockGuard<ReadWriteLockT>&) = delete;
+			ReadWriteLockReadLockGuard<ReadWriteLockT>& operator=(ReadWriteLockReadLockGuard<ReadWriteLockT>&&) = delete;
 		private:
-			ReadWriteLock* m_readWriteLock;
+			ReadWriteLockT* m_readWriteLock;
 	};
+	template<typename ReadWriteLockT = ReadWriteLock>
 	class ReadWriteLockWriteLockGuard
 	{
 		public:
-			inline ReadWriteLockWriteLockGuard(ReadWriteLock& readWriteLock);
-			explicit inline ReadWriteLockWriteLockGuard(ReadWriteLock* readWriteLock);
-			ReadWriteLockWriteLockGuard(const ReadWriteLockWriteLockGuard&) = delete;
-			ReadWriteLockWriteLockGuard(ReadWriteLockWriteLockGuard&&) = delete;
+			inline ReadWriteLockWriteLockGuard(ReadWriteLockT& readWriteLock);
+			explicit inline ReadWriteLockWriteLockGuard(ReadWriteLockT* readWriteLock);
+			ReadWriteLockWriteLockGuard(const ReadWriteLockWriteLockGuard<ReadWriteLockT>&) = delete;
+			ReadWriteLockWriteLockGuard(ReadWriteLockWriteLockGuard<ReadWriteLockT>&&) = delete;
 			inline ~ReadWriteLockWriteLockGuard();
 
-			ReadWriteLockWriteLockGuard& operator=(const ReadWriteLockWriteLockGuard&) = delete;
-			ReadWriteLockWriteLockGuard& operator=(ReadWriteLockWriteLockGuard&&) = delete;
+			ReadWriteLockWriteLockGuard<ReadWriteLockT>& operator=(const ReadWriteLockWriteLockGuard<ReadWriteLockT>&) = delete;
+			ReadWriteLockWriteLockGuard<ReadWriteLockT>& operator=(ReadWriteLockWriteLockGuard<ReadWriteLockT>&&) = delete;
 		private:
-			ReadWriteLock* m_readWriteLock;
+			ReadWriteLockT* m_readWriteLock;
 	};
 }
 
@@ -354,5 +1659,32 @@ namespace fts
 #define FTS_READ_WRITE_WRITE_LOCKGUARD_7(l) fts::ReadWriteLockWriteLockGuard ftsMacroReadWriteLockWriteLockGuardInstance7(l);
 #define FTS_READ_WRITE_WRITE_LOCKGUARD_8(l) fts::ReadWriteLockWriteLockGuard ftsMacroReadWriteLockWriteLockGuardInstance8(l);
 #define FTS_READ_WRITE_WRITE_LOCKGUARD_9(l) fts::ReadWriteLockWriteLockGuard ftsMacroReadWriteLockWriteLockGuardInstance9(l);
+#define FTS_UPGRADEABLE_READ_LOCKGUARD_1(l) fts::UpgradeableRWLockReadLockGuard ftsMacroUpgradeableRWLockReadLockGuardInstance1(l);
+#define FTS_UPGRADEABLE_READ_LOCKGUARD_2(l) fts::UpgradeableRWLockReadLockGuard ftsMacroUpgradeableRWLockReadLockGuardInstance2(l);
+#define FTS_UPGRADEABLE_READ_LOCKGUARD_3(l) fts::UpgradeableRWLockReadLockGuard ftsMacroUpgradeableRWLockReadLockGuardInstance3(l);
+#define FTS_UPGRADEABLE_READ_LOCKGUARD_4(l) fts::UpgradeableRWLockReadLockGuard ftsMacroUpgradeableRWLockReadLockGuardInstance4(l);
+#define FTS_UPGRADEABLE_READ_LOCKGUARD_5(l) fts::UpgradeableRWLockReadLockGuard ftsMacroUpgradeableRWLockReadLockGuardInstance5(l);
+#define FTS_UPGRADEABLE_READ_LOCKGUARD_6(l) fts::UpgradeableRWLockReadLockGuard ftsMacroUpgradeableRWLockReadLockGuardInstance6(l);
+#define FTS_UPGRADEABLE_READ_LOCKGUARD_7(l) fts::UpgradeableRWLockReadLockGuard ftsMacroUpgradeableRWLockReadLockGuardInstance7(l);
+#define FTS_UPGRADEABLE_READ_LOCKGUARD_8(l) fts::UpgradeableRWLockReadLockGuard ftsMacroUpgradeableRWLockReadLockGuardInstance8(l);
+#define FTS_UPGRADEABLE_READ_LOCKGUARD_9(l) fts::UpgradeableRWLockReadLockGuard ftsMacroUpgradeableRWLockReadLockGuardInstance9(l);
+#define FTS_UPGRADEABLE_WRITE_LOCKGUARD_1(l) fts::UpgradeableRWLockWriteLockGuard ftsMacroUpgradeableRWLockWriteLockGuardInstance1(l);
+#define FTS_UPGRADEABLE_WRITE_LOCKGUARD_2(l) fts::UpgradeableRWLockWriteLockGuard ftsMacroUpgradeableRWLockWriteLockGuardInstance2(l);
+#define FTS_UPGRADEABLE_WRITE_LOCKGUARD_3(l) fts::UpgradeableRWLockWriteLockGuard ftsMacroUpgradeableRWLockWriteLockGuardInstance3(l);
+#define FTS_UPGRADEABLE_WRITE_LOCKGUARD_4(l) fts::UpgradeableRWLockWriteLockGuard ftsMacroUpgradeableRWLockWriteLockGuardInstance4(l);
+#define FTS_UPGRADEABLE_WRITE_LOCKGUARD_5(l) fts::UpgradeableRWLockWriteLockGuard ftsMacroUpgradeableRWLockWriteLockGuardInstance5(l);
+#define FTS_UPGRADEABLE_WRITE_LOCKGUARD_6(l) fts::UpgradeableRWLockWriteLockGuard ftsMacroUpgradeableRWLockWriteLockGuardInstance6(l);
+#define FTS_UPGRADEABLE_WRITE_LOCKGUARD_7(l) fts::UpgradeableRWLockWriteLockGuard ftsMacroUpgradeableRWLockWriteLockGuardInstance7(l);
+#define FTS_UPGRADEABLE_WRITE_LOCKGUARD_8(l) fts::UpgradeableRWLockWriteLockGuard ftsMacroUpgradeableRWLockWriteLockGuardInstance8(l);
+#define FTS_UPGRADEABLE_WRITE_LOCKGUARD_9(l) fts::UpgradeableRWLockWriteLockGuard ftsMacroUpgradeableRWLockWriteLockGuardInstance9(l);
+#define FTS_UPGRADEABLE_UPGRADE_LOCKGUARD_1(l) fts::UpgradeableRWLockUpgradeLockGuard ftsMacroUpgradeableRWLockUpgradeLockGuardInstance1(l);
+#define FTS_UPGRADEABLE_UPGRADE_LOCKGUARD_2(l) fts::UpgradeableRWLockUpgradeLockGuard ftsMacroUpgradeableRWLockUpgradeLockGuardInstance2(l);
+#define FTS_UPGRADEABLE_UPGRADE_LOCKGUARD_3(l) fts::UpgradeableRWLockUpgradeLockGuard ftsMacroUpgradeableRWLockUpgradeLockGuardInstance3(l);
+#define FTS_UPGRADEABLE_UPGRADE_LOCKGUARD_4(l) fts::UpgradeableRWLockUpgradeLockGuard ftsMacroUpgradeableRWLockUpgradeLockGuardInstance4(l);
+#define FTS_UPGRADEABLE_UPGRADE_LOCKGUARD_5(l) fts::UpgradeableRWLockUpgradeLockGuard ftsMacroUpgradeableRWLockUpgradeLockGuardInstance5(l);
+#define FTS_UPGRADEABLE_UPGRADE_LOCKGUARD_6(l) fts::UpgradeableRWLockUpgradeLockGuard ftsMacroUpgradeableRWLockUpgradeLockGuardInstance6(l);
+#define FTS_UPGRADEABLE_UPGRADE_LOCKGUARD_7(l) fts::UpgradeableRWLockUpgradeLockGuard ftsMacroUpgradeableRWLockUpgradeLockGuardInstance7(l);
+#define FTS_UPGRADEABLE_UPGRADE_LOCKGUARD_8(l) fts::UpgradeableRWLockUpgradeLockGuard ftsMacroUpgradeableRWLockUpgradeLockGuardInstance8(l);
+#define FTS_UPGRADEABLE_UPGRADE_LOCKGUARD_9(l) fts::UpgradeableRWLockUpgradeLockGuard ftsMacroUpgradeableRWLockUpgradeLockGuardInstance9(l);
 
 #endif //#ifndef FTS_HPP_HEADER_GUARD
\ No newline at end of file
@@ -22,85 +22,282 @@
 
 namespace fts
 {
-	//=========================================SpinLock=========================================
-	inline void SpinLock::lock()
-	{
-		while(true)
-		{
-			if(!this->m_isLocked.exchange(true, std::memory_order_acquire)) [[likely]] break;
-			while(this->m_isLocked.load(std::memory_order_relaxed));
-		}
-	}
-	inline void SpinLock::unlock()
-	{
-		this->m_isLocked.store(false, std::memory_order_release);
-	}
-	inline bool SpinLock::try_lock()
+	//=========================================detail=========================================
+	inline void detail::cpuRelax()
 	{
-		return ! this->m_isLocked.exchange(true, std::memory_order_acquire);
+		#if defined(FTS_COMPILER_MSVC)
+			YieldProcessor();
+		#elif defined(__x86_64__) || defined(__i386__)
+			__builtin_ia32_pause();
+		#elif defined(__aarch64__) || defined(__arm__)
+			asm volatile("yield");
+		#endif
 	}
-
-
-	//=========================================AdaptiveLock========================================
-	inline void AdaptiveLock::lock()
+	inline void detail::futexWait(std::atomic_int32_t* address, int32_t expected)
 	{
 		//platform: linux
 		#ifdef FTS_PLATFORM_LINUX
-			syscall(SYS_futex, &this->m_address, FUTEX_WAIT_PRIVATE, 1, nullptr);
-			this->m_address = 1;
+			syscall(SYS_futex, reinterpret_cast<int32_t*>(address), FUTEX_WAIT_PRIVATE, expected, nullptr);
 		//platform: windows
 		#elif defined(FTS_PLATFORM_WINDOWS)
-			std::cout << "herllo there I am being called from a degenerate operating system" << std::endl;
-			auto value = 1;
-			WaitOnAddress(reinterpret_cast<void*>(&this->m_address), &value, sizeof(value), INFINITE);
-			this->m_address = 1;
+			WaitOnAddress(reinterpret_cast<void*>(address), &expected, sizeof(expected), INFINITE);
 		//platform: unknown
 		#elif defined(FTS_PLATFORM_UNKNOWN)
-			this->m_mutex.lock();
+			address->wait(expected);
 		#endif
 	}
-	inline void AdaptiveLock::unlock()
+	inline bool detail::futexWaitFor(std::atomic_int32_t* address, int32_t expected, std::chrono::nanoseconds timeout)
 	{
+		if(timeout <= std::chrono::nanoseconds::zero()) return false;
 		//platform: linux
 		#ifdef FTS_PLATFORM_LINUX
-			syscall(SYS_futex, &this->m_address, FUTEX_WAKE_PRIVATE, 1, nullptr);
-			this->m_address = 0;
+			auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+			timespec relative;
+			relative.tv_sec = seconds.count();
+			relative.tv_nsec = (timeout - seconds).count();
+			auto result = syscall(SYS_futex, reinterpret_cast<int32_t*>(address), FUTEX_WAIT_PRIVATE, expected, &relative);
+			return result == 0 || errno != ETIMEDOUT;
 		//platform: windows
 		#elif defined(FTS_PLATFORM_WINDOWS)
-		std::cout << "yeet" << std::endl;
-			this->m_address = 0;
-			WakeByAddressSingle(reinterpret_cast<void*>(&this->m_address));
+			//INFINITE is 0xFFFFFFFF, longer timeouts are waited out in slices just below it
+			while(true)
+			{
+				auto milliseconds = std::min<int64_t>(std::chrono::ceil<std::chrono::milliseconds>(timeout).count(), INFINITE - 1);
+				if(WaitOnAddress(reinterpret_cast<void*>(address), &expected, sizeof(expected), static_cast<DWORD>(milliseconds)) || GetLastError() != ERROR_TIMEOUT) return true;
+				timeout -= std::chrono::milliseconds(milliseconds);
+				if(timeout <= std::chrono::nanoseconds::zero()) return false;
+			}
 		//platform: unknown
 		#elif defined(FTS_PLATFORM_UNKNOWN)
-			this->m_mutex.unlock();
+			//std::atomic wait has no timeout
+			auto deadline = detail::deadlineAfter(timeout);
+			while(address->load(std::memory_order_relaxed) == expected)
+			{
+				if(std::chrono::steady_clock::now() >= deadline) return false;
+				std::this_thread::yield();
+			}
+			return true;
 		#endif
 	}
-	inline bool AdaptiveLock::try_lock()
+	inline std::chrono::steady_clock::time_point detail::deadlineAfter(std::chrono::nanoseconds timeout)
+	{
+		auto now = std::chrono::steady_clock::now();
+		if(timeout <= std::chrono::nanoseconds::zero()) return now;
+		if(timeout >= std::chrono::steady_clock::time_point::max() - now) return std::chrono::steady_clock::time_point::max();
+		return now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(timeout);
+	}
+	inline void detail::futexWake(std::atomic_int32_t* address, int32_t count)
 	{
 		//platform: linux
 		#ifdef FTS_PLATFORM_LINUX
-			if(this->m_address == 0)
-			{
-				syscall(SYS_futex, &this->m_address, FUTEX_WAIT_PRIVATE, 1, nullptr);
-				return true;
-			}
-			else return false;
+			syscall(SYS_futex, reinterpret_cast<int32_t*>(address), FUTEX_WAKE_PRIVATE, count, nullptr);
 		//platform: windows
 		#elif defined(FTS_PLATFORM_WINDOWS)
-			if (this->m_address == 0)
+			if(count == 1) WakeByAddressSingle(reinterpret_cast<void*>(address));
+			else WakeByAddressAll(reinterpret_cast<void*>(address));
+		//platform: unknown
+		#elif defined(FTS_PLATFORM_UNKNOWN)
+			if(count == 1) address->notify_one();
+			else address->notify_all();
+		#endif
+	}
+	template<typename DoneT>
+	inline bool detail::waitOnWord(std::atomic_int32_t* word, int32_t waiterBit, DoneT isDone, std::chrono::steady_clock::time_point deadline)
+	{
+		for(int32_t i = 0; i < detail::adaptiveSpinCount; i++)
+		{
+			if(isDone(word->load(std::memory_order_acquire))) [[likely]] return true;
+			detail::cpuRelax();
+		}
+
+		auto value = word->load(std::memory_order_acquire);
+		while(!isDone(value))
+		{
+			if((value & waiterBit) == 0 && !word->compare_exchange_weak(value, value | waiterBit, std::memory_order_acquire, std::memory_order_acquire)) continue;
+			if(deadline == std::chrono::steady_clock::time_point::max())
 			{
-				auto value = 1;
-				WaitOnAddress(reinterpret_cast<void*>(&this->m_address), &value, sizeof(value), INFINITE);
-				this->m_address = 1;
-				return true;
+				detail::futexWait(word, value | waiterBit);
+			}
+			else if(!detail::futexWaitFor(word, value | waiterBit, deadline - std::chrono::steady_clock::now()))
+			{
+				return isDone(word->load(std::memory_order_acquire));
 			}
-			else return false;
+			value = word->load(std::memory_order_acquire);
+		}
+		return true;
+	}
+
+	inline std::atomic_int32_t* detail::lowHalf(std::atomic_uint64_t& word)
+	{
+		static_assert(sizeof(std::atomic_uint64_t) == 2 * sizeof(std::atomic_int32_t), "futex halves need a plain 64 bit atomic");
+		return reinterpret_cast<std::atomic_int32_t*>(&word) + (std::endian::native == std::endian::little ? 0 : 1);
+	}
+	inline std::atomic_int32_t* detail::highHalf(std::atomic_uint64_t& word)
+	{
+		return reinterpret_cast<std::atomic_int32_t*>(&word) + (std::endian::native == std::endian::little ? 1 : 0);
+	}
+
+	inline void detail::ParkingNode::park()
+	{
+		for(int32_t i = 0; i < detail::adaptiveSpinCount; i++)
+		{
+			if(this->isUnparked.load(std::memory_order_acquire) != 0) return;
+			detail::cpuRelax();
+		}
+		while(this->isUnparked.load(std::memory_order_acquire) == 0) detail::futexWait(&this->isUnparked, 0);
+	}
+	inline void detail::ParkingNode::unpark()
+	{
+		//a waiter that sees the store may return and free the node before the wake, a wake on a dead address is harmless
+		auto address = &this->isUnparked;
+		address->store(1, std::memory_order_release);
+		detail::futexWake(address, 1);
+	}
+
+	inline void detail::ParkingQueue::push(ParkingNode& node)
+	{
+		if(this->tail == nullptr) this->head = &node;
+		else this->tail->next = &node;
+		this->tail = &node;
+	}
+	template<typename FitsT>
+	inline detail::ParkingNode* detail::ParkingQueue::detachWhile(FitsT fits)
+	{
+		ParkingNode* detached = nullptr;
+		ParkingNode* last = nullptr;
+		while(this->head != nullptr && fits(*this->head))
+		{
+			if(detached == nullptr) detached = this->head;
+			last = this->head;
+			this->head = this->head->next;
+		}
+		if(last != nullptr) last->next = nullptr;
+		if(this->head == nullptr) this->tail = nullptr;
+		return detached;
+	}
+	inline void detail::ParkingQueue::unparkAll(ParkingNode* nodes)
+	{
+		//each node's next is read before it is unparked since the node dies with its waiter
+		while(nodes != nullptr)
+		{
+			auto next = nodes->next;
+			nodes->unpark();
+			nodes = next;
+		}
+	}
+
+	inline uint32_t detail::threadIndex()
+	{
+		static std::atomic_uint32_t nextIndex(0);
+		thread_local uint32_t index = nextIndex.fetch_add(1, std::memory_order_relaxed);
+		return index;
+	}
+
+	inline bool detail::hasAsymmetricFences()
+	{
+		//platform: linux
+		#if defined(FTS_PLATFORM_LINUX) && defined(SYS_membarrier)
+			static const bool registered = []()
+			{
+				auto commands = syscall(SYS_membarrier, MEMBARRIER_CMD_QUERY, 0);
+				if(commands < 0 || !(commands & MEMBARRIER_CMD_PRIVATE_EXPEDITED)) return false;
+				return syscall(SYS_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0;
+			}();
+			return registered;
+		//platform: windows
+		#elif defined(FTS_PLATFORM_WINDOWS)
+			return true;
 		//platform: unknown
-		#elif defined(FTS_PLATFORM_UNKNOWN)
-			return this->m_mutex.try_lock();
+		#else
+			return false;
+		#endif
+	}
+	inline void detail::asymmetricLightFence()
+	{
+		if(detail::hasAsymmetricFences()) [[likely]] std::atomic_signal_fence(std::memory_order_seq_cst);
+		else std::atomic_thread_fence(std::memory_order_seq_cst);
+	}
+	inline void detail::asymmetricHeavyFence()
+	{
+		if(!detail::hasAsymmetricFences()) [[unlikely]]
+		{
+			std::atomic_thread_fence(std::memory_order_seq_cst);
+			return;
+		}
+		//platform: linux
+		#if defined(FTS_PLATFORM_LINUX) && defined(SYS_membarrier)
+			syscall(SYS_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0);
+		//platform: windows
+		#elif defined(FTS_PLATFORM_WINDOWS)
+			FlushProcessWriteBuffers();
 		#endif
+	}
 
-		return false;
+
+	inline void* detail::ThreadRecords::find(const void* owner) const
+	{
+		for(auto& entry : this->m_entries)
+		{
+			if(entry.owner == owner) return entry.record;
+		}
+		return nullptr;
+	}
+	inline detail::ThreadRecords& detail::threadRecords()
+	{
+		thread_local ThreadRecords records;
+		return records;
+	}
+
+
+	//=========================================SpinLock=========================================
+	inline void SpinLock::lock()
+	{
+		while(true)
+		{
+			if(!this->m_isLocked.exchange(true, std::memory_order_acquire)) [[likely]] break;
+			while(this->m_isLocked.load(std::memory_order_relaxed));
+		}
+	}
+	inline void SpinLock::unlock()
+	{
+		this->m_isLocked.store(false, std::memory_order_release);
+	}
+	inline bool SpinLock::try_lock()
+	{
+		return ! this->m_isLocked.exchange(true, std::memory_order_acquire);
+	}
+
+
+	//=========================================AdaptiveLock========================================
+	inline void AdaptiveLock::lock()
+	{
+		auto state = unlocked;
+		if(this->m_state.compare_exchange_strong(state, locked, std::memory_order_acquire, std::memory_order_relaxed)) [[likely]] return;
+		for(int32_t i = 0; i < detail::adaptiveSpinCount; i++)
+		{
+			detail::cpuRelax();
+			state = unlocked;
+			if(this->m_state.load(std::memory_order_relaxed) == unlocked && this->m_state.compare_exchange_weak(state, locked, std::memory_order_acquire, std::memory_order_relaxed)) return;
+		}
+		this->lockContended();
+	}
+	inline void AdaptiveLock::unlock()
+	{
+		if(this->m_state.exchange(unlocked, std::memory_order_release) == contended) detail::futexWake(&this->m_state, 1);
+	}
+	inline bool AdaptiveLock::try_lock()
+	{
+		auto state = unlocked;
+		return this->m_state.compare_exchange_strong(state, locked, std::memory_order_acquire, std::memory_order_relaxed);
+	}
+
+	inline std::atomic_int32_t* AdaptiveLock::futexWord()
+	{
+		return &this->m_state;
+	}
+	inline void AdaptiveLock::lockContended()
+	{
+		while(this->m_state.exchange(contended, std::memory_order_acquire) != unlocked) detail::futexWait(&this->m_state, contended);
 	}
 
 
@@ -159,297 +356,2053 @@ namespace fts
 	//=========================================AdaptiveSemaphore=========================================
 	inline void AdaptiveSemaphore::lock()
 	{
-		//platform: linux
-		#ifdef FTS_PLATFORM_LINUX
-			while(true)
-			{
-				auto prev = this->m_counter.fetch_sub(1, std::memory_order_acquire);
-				if(prev > 0) [[likely]] return;
-				else
-				{
-					this->m_counter.fetch_add(1, std::memory_order_acquire);
-					syscall(SYS_futex, &this->m_address, FUTEX_WAIT_PRIVATE, 0, nullptr);
-				}
-			}
-		//platform: windows
-		#elif defined(FTS_PLATFORM_WINDOWS)
-			while (true)
-			{
-				auto prev = this->m_counter.fetch_sub(1, std::memory_order_acquire);
-				if(prev > 0) [[likely]] return;
-				else
-				{
-					this->m_counter.fetch_add(1, std::memory_order_acquire);
-					auto value = 1;
-					WaitOnAddress(reinterpret_cast<void*>(&this->m_address), &value, sizeof(value), INFINITE);
-				}
-			}
-		//platform: unknown
-		#elif defined(FTS_PLATFORM_UNKNOWN)
-			while(true)
-			{
-				auto prev = this->m_counter.fetch_sub(1, std::memory_order_acquire);
-				if(prev > 0) [[likely]] return;
-				else
-				{
-					this->m_counter.fetch_add(1, std::memory_order_acquire);
-					this->m_mutex.lock();
-				}
-			}
-		#endif
+		this->acquire(1);
 	}
 	inline void AdaptiveSemaphore::unlock()
 	{
-		//platform: linux
-		#ifdef FTS_PLATFORM_LINUX
-			this->m_counter.fetch_add(1, std::memory_order_acquire);
-			syscall(SYS_futex, &this->m_address, FUTEX_WAKE_PRIVATE, 1, nullptr);
-		//platform: windows
-		#elif defined(FTS_PLATFORM_WINDOWS)
-			this->m_counter.fetch_add(1, std::memory_order_acquire);
-			WakeByAddressSingle(reinterpret_cast<void*>(&m_address));
-		//platform: unknown
-		#elif defined(FTS_PLATFORM_UNKNOWN)
-			this->m_counter.fetch_add(1, std::memory_order_acquire);
-			this->m_mutex.unlock();
-		#endif
+		this->release(1);
 	}
 	inline bool AdaptiveSemaphore::try_lock()
 	{
-		//platform: linux
-		#ifdef FTS_PLATFORM_LINUX
-			while(true)
+		return this->tryAcquire(1);
+	}
+
+	inline void AdaptiveSemaphore::acquire(int32_t n)
+	{
+		for(int32_t i = 0; i < detail::adaptiveSpinCount; i++)
+		{
+			if(this->tryAcquire(n)) [[likely]] return;
+			detail::cpuRelax();
+		}
+
+		auto needed = static_cast<uint64_t>(n);
+		auto threshold = permitBias + needed;
+		auto mixedFlag = n > 1 ? mixedWaiters : 0;
+		auto state = this->m_state.load(std::memory_order_relaxed);
+		while(true)
+		{
+			if((state & permitMask) >= threshold)
 			{
-				auto prev = this->m_counter.fetch_sub(1, std::memory_order_acquire);
-				if(prev > 0) [[likely]] return true;
-				else
-				{
-					this->m_counter.fetch_add(1, std::memory_order_acquire);
-					return false;
-				}
+				if(this->m_state.compare_exchange_weak(state, state - needed, std::memory_order_acquire, std::memory_order_relaxed)) return;
 			}
-		//platform: windows
-		#elif defined(FTS_PLATFORM_WINDOWS)
-			while (true)
+			else if(this->m_state.compare_exchange_weak(state, (state + waiterIncrement) | mixedFlag, std::memory_order_relaxed, std::memory_order_relaxed))
 			{
-				auto prev = this->m_counter.fetch_sub(1, std::memory_order_acquire);
-				if (prev > 0) [[likely]] return true;
-				else
-				{
-					this->m_counter.fetch_add(1, std::memory_order_acquire);
-					return false;
-				}
+				state = (state + waiterIncrement) | mixedFlag;
+				break;
 			}
-		//platform: unknown
-		#elif defined(FTS_PLATFORM_UNKNOWN)
-			while(true)
+		}
+
+		//registered, every release from now on changes the permits so the wait below can not sleep through it
+		while(true)
+		{
+			if((state & permitMask) >= threshold)
 			{
-				auto prev = this->m_counter.fetch_sub(1, std::memory_order_acquire);
-				if(prev > 0) [[likely]] return true;
-				else
-				{
-					this->m_counter.fetch_add(1, std::memory_order_acquire);
-					return false;
-				}
+				//the last waiter to leave clears the mixed flag
+				auto next = state - needed - waiterIncrement;
+				if((next & waiterMask) == 0) next &= ~mixedWaiters;
+				if(this->m_state.compare_exchange_weak(state, next, std::memory_order_acquire, std::memory_order_relaxed)) return;
 			}
-		#endif
+			else
+			{
+				detail::futexWait(detail::lowHalf(this->m_state), static_cast<int32_t>(state & permitMask));
+				state = this->m_state.load(std::memory_order_relaxed);
+			}
+		}
+	}
+	inline void AdaptiveSemaphore::release(int32_t n)
+	{
+		auto prev = this->m_state.fetch_add(static_cast<uint64_t>(n), std::memory_order_release);
+		auto numWaiters = static_cast<int32_t>((prev & waiterMask) >> 32);
+		if(numWaiters == 0) [[likely]] return;
+		if((prev & mixedWaiters) != 0) detail::futexWake(detail::lowHalf(this->m_state), std::numeric_limits<int32_t>::max());
+		else detail::futexWake(detail::lowHalf(this->m_state), std::min(numWaiters, n));
+		detail::notifyWaitAny();
+	}
+	inline bool AdaptiveSemaphore::tryAcquire(int32_t n)
+	{
+		auto needed = static_cast<uint64_t>(n);
+		auto state = this->m_state.load(std::memory_order_relaxed);
+		while((state & permitMask) >= permitBias + needed)
+		{
+			if(this->m_state.compare_exchange_weak(state, state - needed, std::memory_order_acquire, std::memory_order_relaxed)) return true;
+		}
+		return false;
+	}
 
+	inline bool AdaptiveSemaphore::tryWait()
+	{
+		return this->tryAcquire(1);
+	}
+	inline std::atomic_int32_t* AdaptiveSemaphore::futexWord()
+	{
+		return detail::lowHalf(this->m_state);
+	}
+	inline bool AdaptiveSemaphore::armWait(int32_t& expected)
+	{
+		auto state = this->m_state.load(std::memory_order_relaxed);
+		while((state & permitMask) <= permitBias)
+		{
+			if(this->m_state.compare_exchange_weak(state, state + waiterIncrement, std::memory_order_relaxed, std::memory_order_relaxed))
+			{
+				expected = static_cast<int32_t>(state & permitMask);
+				return true;
+			}
+		}
 		return false;
 	}
+	inline void AdaptiveSemaphore::disarmWait()
+	{
+		auto state = this->m_state.load(std::memory_order_relaxed);
+		uint64_t next = 0;
+		do
+		{
+			next = state - waiterIncrement;
+			if((next & waiterMask) == 0) next &= ~mixedWaiters;
+		}
+		while(!this->m_state.compare_exchange_weak(state, next, std::memory_order_relaxed, std::memory_order_relaxed));
+		//the wake that got this thread out may have been meant for a permit it did not take, pass it on
+		if((next & permitMask) > permitBias && (next & waiterMask) != 0)
+		{
+			detail::futexWake(detail::lowHalf(this->m_state), (next & mixedWaiters) != 0 ? std::numeric_limits<int32_t>::max() : 1);
+		}
+	}
 
 	inline void AdaptiveSemaphore::unlockDestoryCounter()
 	{
-		//platform: linux
-		#ifdef FTS_PLATFORM_LINUX
-			syscall(SYS_futex, &this->m_address, FUTEX_WAKE_PRIVATE, 1, nullptr);
-		//platform: windows
-		#elif defined(FTS_PLATFORM_WINDOWS)
-			WakeByAddressSingle(reinterpret_cast<void*>(&m_address));
-		//platform: unknown
-		#elif defined(FTS_PLATFORM_UNKNOWN)
-			this->m_mutex.unlock();
-		#endif
+		return;
 	}
 
 	inline void AdaptiveSemaphore::addCounter(int32_t n)
 	{
-		this->m_counter.fetch_add(n);
+		this->release(n);
 	}
 	inline void AdaptiveSemaphore::removeCounter(int32_t n)
 	{
-		this->m_counter.fetch_sub(n);
+		this->m_state.fetch_sub(static_cast<uint64_t>(n), std::memory_order_relaxed);
 	}
 
 	inline int32_t AdaptiveSemaphore::numCounters() const
 	{
-		return this->m_counter.load();
+		return static_cast<int32_t>(this->m_state.load() & permitMask) - static_cast<int32_t>(permitBias);
 	}
 
-	//=========================================Signal=========================================
-	inline void Signal::wait()
+	//=========================================LightweightSemaphore=========================================
+	inline void LightweightSemaphore::lock()
 	{
-		//platform: linux
-		#ifdef FTS_PLATFORM_LINUX
-			this->m_numWaiting.fetch_add(1);
-			syscall(SYS_futex, &this->m_address, FUTEX_WAIT_PRIVATE, 0, nullptr);
-		//platform: windows
-		#elif defined(FTS_PLATFORM_WINDOWS)
-			this->m_numWaiting.fetch_add(1);
-			auto value = 1;
-			WaitOnAddress(reinterpret_cast<void*>(&this->m_address), &value, sizeof(value), INFINITE);
-		//platform: unknown
-		#elif defined(FTS_PLATFORM_UNKNOWN)
-			this->m_numWaiting.fetch_add(1);
-			this->m_mutex.lock();
-			this->m_unlocked.store(true);
-			this->m_mutex.unlock();
-		#endif
+		this->acquire();
 	}
-	inline void Signal::wake()
+	inline void LightweightSemaphore::unlock()
 	{
-		//platform: linux
-		#ifdef FTS_PLATFORM_LINUX
-			this->m_numWaiting.fetch_sub(1);
-			syscall(SYS_futex, &this->m_address, FUTEX_WAKE_PRIVATE, 1, nullptr);
-		//platform: windows
-		#elif defined(FTS_PLATFORM_WINDOWS)
-			this->m_numWaiting.fetch_sub(1);
-			WakeByAddressSingle(reinterpret_cast<void*>(&this->m_address));
-		//platform: unknown
-		#elif defined(FTS_PLATFORM_UNKNOWN)
-			this->m_unlocked.store(false);
-			this->m_mutex.unlock();
-			while(!this->m_unlocked.load());
-			this->m_mutex.lock();
-			this->m_numWaiting.fetch_sub(1);
-		#endif
+		this->release(1);
 	}
-	inline void Signal::wakeAll()
+	inline bool LightweightSemaphore::try_lock()
 	{
+		return this->tryAcquire();
+	}
+
+	inline void LightweightSemaphore::acquire()
+	{
+		for(int32_t i = 0; i < detail::adaptiveSpinCount; i++)
+		{
+			if(this->tryAcquire()) [[likely]] return;
+			detail::cpuRelax();
+		}
+		//taking the count below zero registers this thread as a sleeper, the release that brings it back up wakes it
+		if(this->m_count.fetch_sub(1, std::memory_order_acquire) > 0) return;
+		this->m_sleepers.acquire();
+	}
+	inline void LightweightSemaphore::release(int32_t n)
+	{
+		auto prev = this->m_count.fetch_add(n, std::memory_order_release);
+		auto numToWake = std::min(-prev, n);
+		if(numToWake > 0) this->m_sleepers.release(numToWake);
+	}
+	inline bool LightweightSemaphore::tryAcquire()
+	{
+		auto count = this->m_count.load(std::memory_order_relaxed);
+		while(count > 0)
+		{
+			if(this->m_count.compare_exchange_weak(count, count - 1, std::memory_order_acquire, std::memory_order_relaxed)) return true;
+		}
+		return false;
+	}
+
+	inline int32_t LightweightSemaphore::numCounters() const
+	{
+		return std::max(this->m_count.load(std::memory_order_relaxed), 0);
+	}
+
+	//=========================================FairSemaphore=========================================
+	inline void FairSemaphore::lock()
+	{
+		this->acquire();
+	}
+	inline void FairSemaphore::unlock()
+	{
+		this->release(1);
+	}
+	inline bool FairSemaphore::try_lock()
+	{
+		return this->tryAcquire();
+	}
+
+	inline void FairSemaphore::acquire()
+	{
+		this->m_lock.lock();
+		//a free permit can only be taken when nobody is queued, otherwise it would be barging
+		if(this->m_waiters.head == nullptr && this->m_permits.load(std::memory_order_relaxed) > 0)
+		{
+			this->m_permits.fetch_sub(1, std::memory_order_relaxed);
+			this->m_lock.unlock();
+			return;
+		}
+		detail::ParkingNode node;
+		this->m_waiters.push(node);
+		this->m_lock.unlock();
+		node.park();
+	}
+	inline void FairSemaphore::release(int32_t n)
+	{
+		this->m_lock.lock();
+		auto woken = this->m_waiters.detachWhile([&n](const detail::ParkingNode&)
+		{
+			if(n == 0) return false;
+			n--;
+			return true;
+		});
+		this->m_permits.fetch_add(n, std::memory_order_relaxed);
+		this->m_lock.unlock();
+
+		//wake outside the lock
+		detail::ParkingQueue::unparkAll(woken);
+	}
+	inline bool FairSemaphore::tryAcquire()
+	{
+		GenericLockGuard<SpinLock> lock(this->m_lock);
+		if(this->m_waiters.head != nullptr || this->m_permits.load(std::memory_order_relaxed) <= 0) return false;
+		this->m_permits.fetch_sub(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	inline int32_t FairSemaphore::numCounters() const
+	{
+		return this->m_permits.load(std::memory_order_relaxed);
+	}
+
+	//=========================================WeightedSemaphore=========================================
+	inline void WeightedSemaphore::lock()
+	{
+		this->acquire(1);
+	}
+	inline void WeightedSemaphore::unlock()
+	{
+		this->release(1);
+	}
+	inline bool WeightedSemaphore::try_lock()
+	{
+		return this->tryAcquire(1);
+	}
+
+	inline void WeightedSemaphore::acquire(int64_t n)
+	{
+		//a request larger than the whole semaphore would sit at the head forever and hold up everyone queued behind it
+		assert(n >= 0 && n <= this->m_capacity);
+		this->m_lock.lock();
+		//head of line, once someone is queued everyone queues behind them even if their own request would fit
+		if(this->m_waiters.head == nullptr && this->m_permits.load(std::memory_order_relaxed) >= n)
+		{
+			this->m_permits.fetch_sub(n, std::memory_order_relaxed);
+			this->m_lock.unlock();
+			return;
+		}
+		detail::ParkingNode node;
+		node.amount = n;
+		this->m_waiters.push(node);
+		this->m_lock.unlock();
+		node.park();
+	}
+	inline void WeightedSemaphore::release(int64_t n)
+	{
+		assert(n >= 0);
+		this->m_lock.lock();
+		auto permits = this->m_permits.load(std::memory_order_relaxed) + n;
+		auto woken = this->m_waiters.detachWhile([&permits](const detail::ParkingNode& node)
+		{
+			if(node.amount > permits) return false;
+			permits -= node.amount;
+			return true;
+		});
+		this->m_permits.store(permits, std::memory_order_relaxed);
+		this->m_lock.unlock();
+
+		//wake outside the lock
+		detail::ParkingQueue::unparkAll(woken);
+	}
+	inline bool WeightedSemaphore::tryAcquire(int64_t n)
+	{
+		if(n < 0 || n > this->m_capacity) return false;
+		GenericLockGuard<SpinLock> lock(this->m_lock);
+		if(this->m_waiters.head != nullptr || this->m_permits.load(std::memory_order_relaxed) < n) return false;
+		this->m_permits.fetch_sub(n, std::memory_order_relaxed);
+		return true;
+	}
+
+	inline int64_t WeightedSemaphore::numCounters() const
+	{
+		return this->m_permits.load(std::memory_order_relaxed);
+	}
+
+	//=========================================ShardedSemaphore=========================================
+	inline void ShardedSemaphore::lock()
+	{
+		this->acquire();
+	}
+	inline void ShardedSemaphore::unlock()
+	{
+		this->release(1);
+	}
+	inline bool ShardedSemaphore::try_lock()
+	{
+		return this->tryAcquire();
+	}
+
+	inline void ShardedSemaphore::acquire()
+	{
+		for(int32_t i = 0; i < detail::adaptiveSpinCount; i++)
+		{
+			if(this->tryAcquire()) [[likely]] return;
+			detail::cpuRelax();
+		}
+		while(true)
+		{
+			//registering before reading the epoch and checking again means a release either sees the waiter or is seen
+			this->m_numWaiting.fetch_add(1, std::memory_order_seq_cst);
+			auto epoch = this->m_epoch.load(std::memory_order_seq_cst);
+			if(this->tryAcquire())
+			{
+				this->m_numWaiting.fetch_sub(1, std::memory_order_relaxed);
+				return;
+			}
+			detail::futexWait(&this->m_epoch, epoch);
+			this->m_numWaiting.fetch_sub(1, std::memory_order_relaxed);
+		}
+	}
+	inline void ShardedSemaphore::release(int32_t n)
+	{
+		this->threadShard().permits.fetch_add(n, std::memory_order_seq_cst);
+		if(this->m_numWaiting.load(std::memory_order_seq_cst) > 0) [[unlikely]]
+		{
+			this->m_epoch.fetch_add(1, std::memory_order_release);
+			detail::futexWake(&this->m_epoch, n);
+		}
+	}
+	inline bool ShardedSemaphore::tryAcquire()
+	{
+		auto& shard = this->threadShard();
+		auto permits = shard.permits.load(std::memory_order_relaxed);
+		while(permits > 0)
+		{
+			if(shard.permits.compare_exchange_weak(permits, permits - 1, std::memory_order_acquire, std::memory_order_relaxed)) [[likely]] return true;
+		}
+		return this->refill(shard);
+	}
+
+	inline int32_t ShardedSemaphore::numCounters() const
+	{
+		auto total = this->m_pool.load(std::memory_order_relaxed);
+		for(uint32_t i = 0; i < this->m_numShards; i++) total += this->m_shards[i].permits.load(std::memory_order_relaxed);
+		return total;
+	}
+	inline int32_t ShardedSemaphore::numCountersExact()
+	{
+		GenericLockGuard<SpinLock> lock(this->m_transferLock);
+		return this->numCounters();
+	}
+
+	inline ShardedSemaphore::Shard& ShardedSemaphore::threadShard()
+	{
+		return this->m_shards[detail::threadIndex() % this->m_numShards];
+	}
+	inline bool ShardedSemaphore::refill(Shard& shard)
+	{
+		GenericLockGuard<SpinLock> lock(this->m_transferLock);
+		auto pooled = this->m_pool.load(std::memory_order_relaxed);
+		if(pooled > 0)
+		{
+			auto batch = std::min(pooled, this->m_batchSize);
+			this->m_pool.store(pooled - batch, std::memory_order_relaxed);
+			if(batch > 1) shard.permits.fetch_add(batch - 1, std::memory_order_relaxed);
+			return true;
+		}
+
+		//the pool is dry, take half of the first other shard that has permits
+		auto first = static_cast<uint32_t>(&shard - this->m_shards.get());
+		for(uint32_t i = 1; i < this->m_numShards; i++)
+		{
+			auto& victim = this->m_shards[(first + i) % this->m_numShards];
+			auto permits = victim.permits.load(std::memory_order_relaxed);
+			while(permits > 0)
+			{
+				auto stolen = (permits + 1) / 2;
+				if(victim.permits.compare_exchange_weak(permits, permits - stolen, std::memory_order_acquire, std::memory_order_relaxed))
+				{
+					if(stolen > 1) shard.permits.fetch_add(stolen - 1, std::memory_order_relaxed);
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	//=========================================RateLimiter=========================================
+	inline void RateLimiter::acquire(int64_t n)
+	{
+		auto now = RateLimiter::now();
+		int64_t readyAt = 0;
+		this->reserve(this->threadBucket(), n, now, std::numeric_limits<int64_t>::max(), readyAt);
+		if(readyAt > now) std::this_thread::sleep_until(Clock::time_point(std::chrono::nanoseconds(readyAt)));
+	}
+	inline bool RateLimiter::tryAcquire(int64_t n)
+	{
+		auto now = RateLimiter::now();
+		int64_t readyAt = 0;
+		//fall back to the other buckets before giving up so sharding does not make a thread fail while tokens are left
+		auto first = static_cast<uint32_t>(&this->threadBucket() - this->m_buckets.get());
+		for(uint32_t i = 0; i < this->m_numBuckets; i++)
+		{
+			if(this->reserve(this->m_buckets[(first + i) % this->m_numBuckets], n, now, now, readyAt)) return true;
+		}
+		return false;
+	}
+	inline bool RateLimiter::tryAcquireUntil(int64_t n, Clock::time_point deadline)
+	{
+		auto now = RateLimiter::now();
+		int64_t readyAt = 0;
+		auto deadlineNs = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+		if(!this->reserve(this->threadBucket(), n, now, deadlineNs, readyAt)) return false;
+		if(readyAt > now) std::this_thread::sleep_until(Clock::time_point(std::chrono::nanoseconds(readyAt)));
+		return true;
+	}
+
+	inline bool RateLimiter::reserve(Bucket& bucket, int64_t n, int64_t now, int64_t deadline, int64_t& readyAt)
+	{
+		auto cost = static_cast<int64_t>(static_cast<double>(n) * this->m_interval);
+		auto theoreticalArrival = bucket.theoreticalArrival.load(std::memory_order_relaxed);
+		while(true)
+		{
+			//a bucket that has been idle is full, it can not bank more than the burst
+			auto next = std::max(theoreticalArrival, now) + cost;
+			readyAt = next - this->m_tolerance;
+			if(readyAt > deadline) return false;
+			if(bucket.theoreticalArrival.compare_exchange_weak(theoreticalArrival, next, std::memory_order_relaxed, std::memory_order_relaxed)) return true;
+		}
+	}
+	inline RateLimiter::Bucket& RateLimiter::threadBucket()
+	{
+		return this->m_buckets[detail::threadIndex() % this->m_numBuckets];
+	}
+	inline int64_t RateLimiter::now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+	}
+
+	//=========================================Signal=========================================
+	inline void Signal::wait()
+	{
+		this->m_numWaiting.fetch_add(1, std::memory_order_seq_cst);
+		auto pending = this->m_pendingWakes.load(std::memory_order_relaxed);
+		while(true)
+		{
+			if(pending > 0)
+			{
+				if(this->m_pendingWakes.compare_exchange_weak(pending, pending - 1, std::memory_order_acquire, std::memory_order_relaxed)) return;
+			}
+			else
+			{
+				detail::futexWait(&this->m_pendingWakes, 0);
+				pending = this->m_pendingWakes.load(std::memory_order_relaxed);
+			}
+		}
+	}
+	inline void Signal::wake()
+	{
+		//only a thread that is waiting can be woken, claim one of them before handing it a wake
+		auto numWaiting = this->m_numWaiting.load(std::memory_order_seq_cst);
+		while(numWaiting > 0)
+		{
+			if(this->m_numWaiting.compare_exchange_weak(numWaiting, numWaiting - 1, std::memory_order_relaxed, std::memory_order_relaxed))
+			{
+				this->m_pendingWakes.fetch_add(1, std::memory_order_release);
+				detail::futexWake(&this->m_pendingWakes, 1);
+				return;
+			}
+		}
+	}
+	inline void Signal::wakeAll()
+	{
+		auto numWaiting = this->m_numWaiting.exchange(0, std::memory_order_seq_cst);
+		if(numWaiting == 0) return;
+		this->m_pendingWakes.fetch_add(numWaiting, std::memory_order_release);
+		detail::futexWake(&this->m_pendingWakes, std::numeric_limits<int32_t>::max());
+	}
+
+	inline bool Signal::hasWaitingThread()
+	{
+		return this->m_numWaiting.load() > 0;
+	}
+
+
+	//=========================================SpinSignal=========================================
+	inline void SpinSignal::wait()
+	{
+		this->m_isWaiting.store(2, std::memory_order_release);
+		while(true)
+		{
+			if(this->m_isWaiting.load(std::memory_order_relaxed) == 1)
+			{
+				this->m_isWaiting.fetch_add(1, std::memory_order_acquire);
+				return;
+			}
+			else if(this->m_isWaiting.load(std::memory_order_relaxed) == 0)
+			{
+				return;
+			}
+		}
+	}
+	inline void SpinSignal::wake()
+	{
+		this->m_isWaiting.store(1, std::memory_order_release);
+	}
+	inline void SpinSignal::wakeAll()
+	{
+		this->m_isWaiting.store(0, std::memory_order_release);
+	}
+
+	inline bool SpinSignal::hasWaitingThread()
+	{
+		return this->m_isWaiting.load() > 0;
+	}
+
+
+	//=========================================ConditionVariable=========================================
+	inline void ConditionVariable::notifyOne()
+	{
+		this->m_sequence.fetch_add(1, std::memory_order_seq_cst);
+		if(this->m_numWaiters.load(std::memory_order_seq_cst) != 0) detail::futexWake(&this->m_sequence, 1);
+	}
+	inline void ConditionVariable::notifyAll()
+	{
+		auto sequence = this->m_sequence.fetch_add(1, std::memory_order_seq_cst) + 1;
+		if(this->m_numWaiters.load(std::memory_order_seq_cst) == 0) return;
 		//platform: linux
 		#ifdef FTS_PLATFORM_LINUX
-			this->m_numWaiting.store(0);
-			syscall(SYS_futex, &this->m_address, FUTEX_WAKE_PRIVATE, std::numeric_limits<int>::max(), nullptr);
-		//platform: windows
-		#elif defined(FTS_PLATFORM_WINDOWS)
-			this->m_numWaiting.store(0);
-			WakeByAddressAll(reinterpret_cast<void*>(&this->m_address));
-		//platform: unknown
-		#elif defined(FTS_PLATFORM_UNKNOWN)
-			for(int32_t i = this->m_numWaiting.load(); i > 0; i--)
+			auto lockWord = this->m_lockWord.load(std::memory_order_relaxed);
+			if(lockWord != nullptr)
 			{
-				this->m_unlocked.store(false);
-				this->m_mutex.unlock();
-				while(!m_unlocked.load());
-				this->m_mutex.lock();
+				//wakes one and moves the rest onto the lock, the woken thread locks with lockContended() so its unlock wakes
+				//the next and so on. Fails with EAGAIN when another notify moved the sequence on in between
+				while(syscall(SYS_futex, reinterpret_cast<int32_t*>(&this->m_sequence), FUTEX_CMP_REQUEUE_PRIVATE, 1, static_cast<long>(std::numeric_limits<int32_t>::max()),
+					reinterpret_cast<int32_t*>(lockWord), sequence) < 0 && errno == EAGAIN)
+				{
+					sequence = this->m_sequence.load(std::memory_order_relaxed);
+				}
+				return;
 			}
-			this->m_numWaiting.store(0);
 		#endif
+		detail::futexWake(&this->m_sequence, std::numeric_limits<int32_t>::max());
+	}
+
+	template<typename LockT>
+	inline void ConditionVariable::wait(LockT& lock)
+	{
+		this->waitUntil(lock, std::chrono::steady_clock::time_point::max());
+	}
+	template<typename LockT, typename PredicateT>
+	inline void ConditionVariable::wait(LockT& lock, PredicateT predicate)
+	{
+		while(!predicate()) this->wait(lock);
+	}
+	template<typename LockT>
+	inline bool ConditionVariable::waitFor(LockT& lock, std::chrono::nanoseconds timeout)
+	{
+		return this->waitUntil(lock, detail::deadlineAfter(timeout));
+	}
+	template<typename LockT>
+	inline bool ConditionVariable::waitUntil(LockT& lock, std::chrono::steady_clock::time_point deadline)
+	{
+		constexpr bool isFutexLock = requires(LockT& futexLock) { futexLock.futexWord(); futexLock.lockContended(); };
+
+		this->m_numWaiters.fetch_add(1, std::memory_order_seq_cst);
+		auto sequence = this->m_sequence.load(std::memory_order_seq_cst);
+		if constexpr(isFutexLock) this->m_lockWord.store(lock.futexWord(), std::memory_order_relaxed);
+		lock.unlock();
+
+		auto isNotified = true;
+		if(deadline == std::chrono::steady_clock::time_point::max()) detail::futexWait(&this->m_sequence, sequence);
+		else isNotified = detail::futexWaitFor(&this->m_sequence, sequence, deadline - std::chrono::steady_clock::now());
+
+		this->m_numWaiters.fetch_sub(1, std::memory_order_relaxed);
+		//this thread may have been requeued onto the lock, other requeued threads are only woken if it locks as contended
+		if constexpr(isFutexLock) lock.lockContended();
+		else lock.lock();
+		return isNotified;
+	}
+	template<typename LockT, typename PredicateT>
+	inline bool ConditionVariable::waitFor(LockT& lock, std::chrono::nanoseconds timeout, PredicateT predicate)
+	{
+		return this->waitUntil(lock, detail::deadlineAfter(timeout), std::move(predicate));
+	}
+	template<typename LockT, typename PredicateT>
+	inline bool ConditionVariable::waitUntil(LockT& lock, std::chrono::steady_clock::time_point deadline, PredicateT predicate)
+	{
+		while(!predicate())
+		{
+			if(!this->waitUntil(lock, deadline)) return predicate();
+		}
+		return true;
+	}
+
+
+	//=========================================AutoResetEvent=========================================
+	inline void AutoResetEvent::set()
+	{
+		auto state = this->m_state.load(std::memory_order_relaxed);
+		while(true)
+		{
+			if((state & setBit) != 0) return;
+			if(this->m_state.compare_exchange_weak(state, state | setBit, std::memory_order_release, std::memory_order_relaxed)) break;
+		}
+		if(state >= waiterIncrement)
+		{
+			detail::futexWake(&this->m_state, 1);
+			detail::notifyWaitAny();
+		}
+	}
+	inline void AutoResetEvent::reset()
+	{
+		this->m_state.fetch_and(~setBit, std::memory_order_relaxed);
+	}
+	inline void AutoResetEvent::wait()
+	{
+		for(int32_t i = 0; i < detail::adaptiveSpinCount; i++)
+		{
+			if(this->tryWait()) [[likely]] return;
+			detail::cpuRelax();
+		}
+
+		auto state = this->m_state.load(std::memory_order_relaxed);
+		while(true)
+		{
+			if((state & setBit) != 0)
+			{
+				if(this->m_state.compare_exchange_weak(state, state & ~setBit, std::memory_order_acquire, std::memory_order_relaxed)) return;
+			}
+			else if(this->m_state.compare_exchange_weak(state, state + waiterIncrement, std::memory_order_relaxed, std::memory_order_relaxed))
+			{
+				state += waiterIncrement;
+				break;
+			}
+		}
+		//registered, a set() from now on changes the word so the wait below can not sleep through it
+		while(true)
+		{
+			if((state & setBit) != 0)
+			{
+				if(this->m_state.compare_exchange_weak(state, (state & ~setBit) - waiterIncrement, std::memory_order_acquire, std::memory_order_relaxed)) return;
+			}
+			else
+			{
+				detail::futexWait(&this->m_state, state);
+				state = this->m_state.load(std::memory_order_relaxed);
+			}
+		}
+	}
+	inline bool AutoResetEvent::tryWait()
+	{
+		auto state = this->m_state.load(std::memory_order_relaxed);
+		while((state & setBit) != 0)
+		{
+			if(this->m_state.compare_exchange_weak(state, state & ~setBit, std::memory_order_acquire, std::memory_order_relaxed)) return true;
+		}
+		return false;
+	}
+
+	inline std::atomic_int32_t* AutoResetEvent::futexWord()
+	{
+		return &this->m_state;
+	}
+	inline bool AutoResetEvent::armWait(int32_t& expected)
+	{
+		auto state = this->m_state.load(std::memory_order_relaxed);
+		while((state & setBit) == 0)
+		{
+			if(this->m_state.compare_exchange_weak(state, state + waiterIncrement, std::memory_order_relaxed, std::memory_order_relaxed))
+			{
+				expected = state + waiterIncrement;
+				return true;
+			}
+		}
+		return false;
+	}
+	inline void AutoResetEvent::disarmWait()
+	{
+		auto next = this->m_state.fetch_sub(waiterIncrement, std::memory_order_relaxed) - waiterIncrement;
+		//the wake that got this thread out may have been meant for a set() it did not consume, pass it on
+		if((next & setBit) != 0 && next >= waiterIncrement) detail::futexWake(&this->m_state, 1);
+	}
+
+	inline bool AutoResetEvent::isSet() const
+	{
+		return (this->m_state.load(std::memory_order_acquire) & setBit) != 0;
+	}
+
+
+	//=========================================ManualResetEvent=========================================
+	inline void ManualResetEvent::set()
+	{
+		//clearing the waiter bit is fine since every waiter is woken
+		auto prev = this->m_state.exchange(setBit, std::memory_order_release);
+		if((prev & waiterBit) != 0)
+		{
+			detail::futexWake(&this->m_state, std::numeric_limits<int32_t>::max());
+			detail::notifyWaitAny();
+		}
+	}
+	inline void ManualResetEvent::reset()
+	{
+		this->m_state.fetch_and(~setBit, std::memory_order_relaxed);
+	}
+	inline void ManualResetEvent::wait()
+	{
+		detail::waitOnWord(&this->m_state, waiterBit, [](int32_t state) { return (state & setBit) != 0; });
+	}
+
+
+	inline bool ManualResetEvent::tryWait()
+	{
+		return this->isSet();
+	}
+	inline std::atomic_int32_t* ManualResetEvent::futexWord()
+	{
+		return &this->m_state;
+	}
+	inline bool ManualResetEvent::armWait(int32_t& expected)
+	{
+		auto state = this->m_state.load(std::memory_order_relaxed);
+		while((state & setBit) == 0)
+		{
+			if((state & waiterBit) != 0 || this->m_state.compare_exchange_weak(state, state | waiterBit, std::memory_order_relaxed, std::memory_order_relaxed))
+			{
+				expected = state | waiterBit;
+				return true;
+			}
+		}
+		return false;
+	}
+	inline void ManualResetEvent::disarmWait()
+	{
+		//the waiter bit may belong to other waiters too, leaving it costs at most one needless wake
+	}
+
+	inline bool ManualResetEvent::isSet() const
+	{
+		return (this->m_state.load(std::memory_order_acquire) & setBit) != 0;
+	}
+
+
+	//=========================================flag=========================================
+	inline void Flag::raise()
+	{
+		auto state = this->m_state.load(std::memory_order_relaxed);
+		while(true)
+		{
+			if((state & raisedBit) != 0) return;
+			//clearing the waiter bit is fine since every waiter is woken and waiters for the other state register again
+			if(this->m_state.compare_exchange_weak(state, raisedBit, std::memory_order_seq_cst, std::memory_order_relaxed)) break;
+		}
+		if((state & waiterBit) != 0)
+		{
+			detail::futexWake(&this->m_state, std::numeric_limits<int32_t>::max());
+			detail::notifyWaitAny();
+		}
+	}
+	inline void Flag::lower()
+	{
+		auto state = this->m_state.load(std::memory_order_relaxed);
+		while(true)
+		{
+			if((state & raisedBit) == 0) return;
+			if(this->m_state.compare_exchange_weak(state, 0, std::memory_order_seq_cst, std::memory_order_relaxed)) break;
+		}
+		if((state & waiterBit) != 0) detail::futexWake(&this->m_state, std::numeric_limits<int32_t>::max());
+	}
+	inline bool Flag::isRaised()
+	{
+		return (this->m_state.load() & raisedBit) != 0;
+	}
+
+	inline void Flag::waitRaised()
+	{
+		this->waitUntil(raisedBit, std::chrono::steady_clock::time_point::max());
+	}
+	inline void Flag::waitLowered()
+	{
+		this->waitUntil(0, std::chrono::steady_clock::time_point::max());
+	}
+	inline bool Flag::waitRaisedFor(std::chrono::nanoseconds timeout)
+	{
+		return this->waitUntil(raisedBit, detail::deadlineAfter(timeout));
+	}
+	inline bool Flag::waitLoweredFor(std::chrono::nanoseconds timeout)
+	{
+		return this->waitUntil(0, detail::deadlineAfter(timeout));
+	}
+
+	inline bool Flag::tryWait()
+	{
+		return this->isRaised();
+	}
+	inline std::atomic_int32_t* Flag::futexWord()
+	{
+		return &this->m_state;
+	}
+	inline bool Flag::armWait(int32_t& expected)
+	{
+		auto state = this->m_state.load(std::memory_order_relaxed);
+		while((state & raisedBit) == 0)
+		{
+			if((state & waiterBit) != 0 || this->m_state.compare_exchange_weak(state, state | waiterBit, std::memory_order_relaxed, std::memory_order_relaxed))
+			{
+				expected = state | waiterBit;
+				return true;
+			}
+		}
+		return false;
+	}
+	inline void Flag::disarmWait()
+	{
+		//the waiter bit may belong to other waiters too, leaving it costs at most one needless wake
+	}
+
+	inline bool Flag::waitUntil(int32_t wanted, std::chrono::steady_clock::time_point deadline)
+	{
+		return detail::waitOnWord(&this->m_state, waiterBit, [wanted](int32_t state) { return (state & raisedBit) == wanted; }, deadline);
+	}
+
+
+
+	//=========================================EventCount=========================================
+	inline EventCount::Key::Key(uint32_t epoch)
+	: m_epoch(epoch) {}
+
+	inline void EventCount::notify()
+	{
+		this->notify(1);
+	}
+	inline void EventCount::notifyAll()
+	{
+		this->notify(std::numeric_limits<int32_t>::max());
+	}
+
+	inline EventCount::Key EventCount::prepareWait()
+	{
+		auto prev = this->m_state.fetch_add(waiterIncrement, std::memory_order_acq_rel);
+		return Key(static_cast<uint32_t>(prev >> epochShift));
+	}
+	inline void EventCount::cancelWait()
+	{
+		this->m_state.fetch_sub(waiterIncrement, std::memory_order_relaxed);
+	}
+	inline void EventCount::commitWait(Key key)
+	{
+		while(static_cast<uint32_t>(this->m_state.load(std::memory_order_acquire) >> epochShift) == key.m_epoch)
+		{
+			detail::futexWait(detail::highHalf(this->m_state), static_cast<int32_t>(key.m_epoch));
+		}
+		this->m_state.fetch_sub(waiterIncrement, std::memory_order_relaxed);
+	}
+
+	template<typename ConditionT>
+	inline void EventCount::await(ConditionT&& condition)
+	{
+		if(condition()) return;
+		while(true)
+		{
+			auto key = this->prepareWait();
+			if(condition())
+			{
+				this->cancelWait();
+				return;
+			}
+			this->commitWait(key);
+		}
+	}
+
+	inline void EventCount::notify(int32_t n)
+	{
+		//the epoch always moves so a waiter's commitWait(key) sees it changed and does not sleep, prepareWait() already
+		//counted that waiter which is why the wake can be skipped while the waiter count is zero
+		auto prev = this->m_state.fetch_add(epochIncrement, std::memory_order_acq_rel);
+		if((prev & waiterMask) != 0) [[unlikely]] detail::futexWake(detail::highHalf(this->m_state), n);
+	}
+
+
+	//=========================================Barrier=========================================
+	inline void Barrier::arriveAndWait(uint32_t threadIndex)
+	{
+		assert(threadIndex < this->m_numThreads);
+		if(this->m_algorithm == BarrierAlgorithm::Dissemination) this->arriveDissemination(threadIndex);
+		else this->arriveOnTree(threadIndex);
+	}
+	inline uint32_t Barrier::numThreads() const
+	{
+		return this->m_numThreads;
+	}
+
+	inline bool Barrier::hasReached(int32_t value, uint32_t phase)
+	{
+		return static_cast<int32_t>(static_cast<uint32_t>(value & ~sleepingBit) - (phase << 1)) >= 0;
+	}
+	inline void Barrier::waitForPhase(PhaseFlag& flag, uint32_t phase)
+	{
+		detail::waitOnWord(&flag.value, sleepingBit, [phase](int32_t value) { return hasReached(value, phase); });
+	}
+
+	inline void Barrier::publishPhase(PhaseFlag& flag, uint32_t phase)
+	{
+		auto prev = flag.value.exchange(static_cast<int32_t>(phase << 1), std::memory_order_release);
+		if((prev & sleepingBit) != 0) detail::futexWake(&flag.value, std::numeric_limits<int32_t>::max());
+	}
+	inline void Barrier::arriveOnTree(uint32_t threadIndex)
+	{
+		auto phase = ++this->m_participants[threadIndex].phase;
+		//the nodes this thread was last to arrive at, it releases their waiters once it has been released itself
+		uint32_t climbed[maxTreeDepth];
+		uint32_t numClimbed = 0;
+		auto index = this->m_algorithm == BarrierAlgorithm::SenseReversing ? 0 : threadIndex / treeArity;
+		while(true)
+		{
+			auto& node = this->m_nodes[index];
+			if(node.count.fetch_sub(1, std::memory_order_acq_rel) != 1)
+			{
+				waitForPhase(node.release, phase);
+				break;
+			}
+			//last to arrive, nobody touches this node again until its waiters have been released
+			node.count.store(node.numArrivals, std::memory_order_relaxed);
+			climbed[numClimbed++] = index;
+			if(node.parent == noParent)
+			{
+				if(this->m_completion) this->m_completion();
+				break;
+			}
+			index = node.parent;
+		}
+		//top down so the larger subtrees start waking first
+		while(numClimbed > 0) publishPhase(this->m_nodes[climbed[--numClimbed]].release, phase);
+	}
+	inline void Barrier::arriveDissemination(uint32_t threadIndex)
+	{
+		auto phase = ++this->m_participants[threadIndex].phase;
+		uint32_t distance = 1;
+		for(uint32_t round = 0; round < this->m_numRounds; round++, distance <<= 1)
+		{
+			auto partner = (threadIndex + distance) % this->m_numThreads;
+			publishPhase(this->m_flags[partner * this->m_numRounds + round], phase);
+			waitForPhase(this->m_flags[threadIndex * this->m_numRounds + round], phase);
+		}
+		//every thread knows the whole team has arrived, only the completion function still has to be waited for
+		if(!this->m_completion) return;
+		if(threadIndex == 0) this->complete(phase);
+		else waitForPhase(this->m_phase, phase);
+	}
+	inline void Barrier::complete(uint32_t phase)
+	{
+		if(this->m_completion) this->m_completion();
+		publishPhase(this->m_phase, phase);
+	}
+
+
+	//=========================================Latch=========================================
+	inline void Latch::countDown(int32_t n)
+	{
+		auto prev = this->m_state.fetch_sub(n * countIncrement, std::memory_order_release);
+		//counting down past zero would leave every waiter asleep for ever
+		assert(prev / countIncrement >= n);
+		if(prev / countIncrement == n && (prev & waiterBit) != 0) [[unlikely]] detail::futexWake(&this->m_state, std::numeric_limits<int32_t>::max());
+	}
+	inline void Latch::wait()
+	{
+		detail::waitOnWord(&this->m_state, waiterBit, [](int32_t state) { return state / countIncrement == 0; });
+	}
+
+	inline bool Latch::tryWait() const
+	{
+		return this->m_state.load(std::memory_order_acquire) / countIncrement == 0;
+	}
+	inline void Latch::arriveAndWait(int32_t n)
+	{
+		this->countDown(n);
+		this->wait();
+	}
+
+
+	//=========================================WaitGroup=========================================
+	inline void WaitGroup::add(int32_t n)
+	{
+		auto prev = this->m_state.fetch_add(n * countIncrement, std::memory_order_release);
+		//a negative count would leave every waiter asleep for ever
+		assert(prev / countIncrement + n >= 0);
+		if(prev / countIncrement + n == 0 && (prev & waiterBit) != 0) [[unlikely]]
+		{
+			//the next round's waiters may set the bit again first, clearing theirs only costs them a spurious wake since
+			//every thread asleep by now is woken
+			this->m_state.fetch_and(~waiterBit, std::memory_order_relaxed);
+			detail::futexWake(&this->m_state, std::numeric_limits<int32_t>::max());
+		}
+	}
+	inline void WaitGroup::done(int32_t n)
+	{
+		this->add(-n);
+	}
+	inline void WaitGroup::wait()
+	{
+		detail::waitOnWord(&this->m_state, waiterBit, [](int32_t state) { return state / countIncrement == 0; });
+	}
+
+	inline bool WaitGroup::tryWait() const
+	{
+		return this->m_state.load(std::memory_order_acquire) / countIncrement == 0;
+	}
+
+
+	//=========================================Phaser=========================================
+	inline uint32_t Phaser::registerParty()
+	{
+		return this->registerParties(1);
+	}
+	inline uint32_t Phaser::registerParties(uint32_t n)
+	{
+		auto state = this->m_state.load(std::memory_order_relaxed);
+		while(true)
+		{
+			//more parties would carry into the phase
+			assert(n <= maxParties - ((state >> partiesShift) & countMask));
+			if(this->m_parent != nullptr && ((state >> partiesShift) & countMask) == 0) break;
+			if(this->m_state.compare_exchange_weak(state, state + n * partyIncrement + n, std::memory_order_acq_rel, std::memory_order_relaxed)) return phaseOf(state);
+		}
+
+		//an empty tier is not a party of its parent and its phase may be behind, it joins in the parent's current phase
+		GenericLockGuard<SpinLock> lock(this->m_registrationLock);
+		state = this->m_state.load(std::memory_order_relaxed);
+		while(((state >> partiesShift) & countMask) != 0)
+		{
+			assert(n <= maxParties - ((state >> partiesShift) & countMask));
+			if(this->m_state.compare_exchange_weak(state, state + n * partyIncrement + n, std::memory_order_acq_rel, std::memory_order_relaxed)) return phaseOf(state);
+		}
+		auto phase = this->m_parent->registerParty();
+		this->m_state.store(makeState(phase, n), std::memory_order_release);
+		return phase;
+	}
+	inline uint32_t Phaser::arrive()
+	{
+		return this->doArrive(false);
+	}
+	inline uint32_t Phaser::arriveAndDeregister()
+	{
+		return this->doArrive(true);
+	}
+	inline uint32_t Phaser::arriveAndAwaitAdvance()
+	{
+		auto phase = this->arrive();
+		this->awaitAdvance(phase);
+		return phase;
+	}
+	inline uint32_t Phaser::awaitAdvance(uint32_t phase)
+	{
+		auto& rootState = this->m_root->m_state;
+		for(int32_t i = 0; i < detail::adaptiveSpinCount; i++)
+		{
+			auto current = phaseOf(rootState.load(std::memory_order_acquire));
+			if(hasAdvanced(current, phase)) [[likely]] return current;
+			detail::cpuRelax();
+		}
+
+		auto state = rootState.load(std::memory_order_acquire);
+		while(!hasAdvanced(phaseOf(state), phase))
+		{
+			if((state & waiterBit) == 0 && !rootState.compare_exchange_weak(state, state | waiterBit, std::memory_order_acquire, std::memory_order_acquire)) continue;
+			detail::futexWait(detail::highHalf(rootState), static_cast<int32_t>(static_cast<uint32_t>((state | waiterBit) >> phaseShift)));
+			state = rootState.load(std::memory_order_acquire);
+		}
+		return phaseOf(state);
+	}
+
+	inline uint32_t Phaser::phase() const
+	{
+		return phaseOf(this->m_root->m_state.load(std::memory_order_acquire));
+	}
+	inline uint32_t Phaser::numParties() const
+	{
+		return static_cast<uint32_t>((this->m_state.load(std::memory_order_relaxed) >> partiesShift) & countMask);
+	}
+	inline uint32_t Phaser::numUnarrived() const
+	{
+		return static_cast<uint32_t>(this->m_state.load(std::memory_order_relaxed) & countMask);
+	}
+	inline Phaser* Phaser::parent() const
+	{
+		return this->m_parent;
+	}
+
+	inline uint64_t Phaser::makeState(uint32_t phase, uint32_t parties)
+	{
+		return (uint64_t(phase & phaseMask) << phaseShift) | (uint64_t(parties) << partiesShift) | parties;
+	}
+	inline uint32_t Phaser::phaseOf(uint64_t state)
+	{
+		return static_cast<uint32_t>(state >> phaseShift) & phaseMask;
+	}
+	inline bool Phaser::hasAdvanced(uint32_t rootPhase, uint32_t phase)
+	{
+		auto distance = (rootPhase - phase) & phaseMask;
+		return distance != 0 && distance <= phaseMask / 2;
+	}
+	inline uint32_t Phaser::doArrive(bool isDeregistering)
+	{
+		auto state = this->m_state.load(std::memory_order_relaxed);
+		while(true)
+		{
+			//nobody left to arrive means there are no parties or every one of them has arrived already, arriving anyway
+			//would start the next phase early or take the parties below zero
+			assert((state & countMask) != 0);
+			auto phase = phaseOf(state);
+			auto parties = static_cast<uint32_t>((state >> partiesShift) & countMask) - (isDeregistering ? 1 : 0);
+			if((state & countMask) > 1)
+			{
+				auto next = state - 1 - (isDeregistering ? partyIncrement : 0);
+				if(this->m_state.compare_exchange_weak(state, next, std::memory_order_acq_rel, std::memory_order_relaxed)) return phase;
+				continue;
+			}
+
+			//last to arrive, the root moves the whole tree on while a tier starts its next phase and passes the arrival up
+			if(!this->m_state.compare_exchange_weak(state, makeState(phase + 1, parties), std::memory_order_acq_rel, std::memory_order_relaxed)) continue;
+			if(this->m_parent == nullptr)
+			{
+				if((state & waiterBit) != 0) detail::futexWake(detail::highHalf(this->m_state), std::numeric_limits<int32_t>::max());
+			}
+			else if(parties == 0) this->m_parent->arriveAndDeregister();
+			else this->m_parent->arrive();
+			return phase;
+		}
+	}
+
+
+	//=========================================OneShot=========================================
+	template<typename T>
+	template<typename... Args>
+	inline bool OneShot<T>::set(Args&&... args)
+	{
+		if((this->m_state.fetch_or(settingBit, std::memory_order_relaxed) & settingBit) != 0) [[unlikely]] return false;
+		auto stored = new(this->m_storage) T(std::forward<Args>(args)...);
+
+		//a reader may destroy this as soon as the ready bit is visible, so a registered continuation runs before it is
+		//published. then() only registers while the value is not ready, a failed exchange means it just did
+		auto address = &this->m_state;
+		auto state = address->load(std::memory_order_acquire);
+		while(true)
+		{
+			if((state & continuationBit) != 0)
+			{
+				this->m_continuation(*stored, this->m_context);
+				state = address->fetch_or(readyBit, std::memory_order_release);
+				break;
+			}
+			if(address->compare_exchange_weak(state, state | readyBit, std::memory_order_release, std::memory_order_acquire)) break;
+		}
+
+		//a wake on a dead address is harmless
+		if((state & waiterBit) != 0) detail::futexWake(address, std::numeric_limits<int32_t>::max());
+		return true;
+	}
+	template<typename T>
+	inline T& OneShot<T>::get()
+	{
+		this->waitUntil(std::chrono::steady_clock::time_point::max());
+		return *this->value();
+	}
+	template<typename T>
+	inline T* OneShot<T>::tryGet()
+	{
+		return this->isReady() ? this->value() : nullptr;
+	}
+	template<typename T>
+	inline bool OneShot<T>::waitFor(std::chrono::nanoseconds timeout)
+	{
+		return this->waitUntil(detail::deadlineAfter(timeout));
+	}
+	template<typename T>
+	inline bool OneShot<T>::isReady() const
+	{
+		return (this->m_state.load(std::memory_order_acquire) & readyBit) != 0;
+	}
+	template<typename T>
+	inline bool OneShot<T>::then(Continuation continuation, void* context)
+	{
+		if((this->m_state.fetch_or(registeringBit, std::memory_order_relaxed) & registeringBit) != 0) [[unlikely]] return false;
+		this->m_continuation = continuation;
+		this->m_context = context;
+		//registered only while the value is not ready, otherwise set() is past looking for a continuation and it runs here
+		auto state = this->m_state.load(std::memory_order_acquire);
+		while((state & readyBit) == 0)
+		{
+			if(this->m_state.compare_exchange_weak(state, state | continuationBit, std::memory_order_release, std::memory_order_acquire)) return true;
+		}
+		continuation(*this->value(), context);
+		return true;
+	}
+
+	template<typename T>
+	inline T* OneShot<T>::value()
+	{
+		return std::launder(reinterpret_cast<T*>(this->m_storage));
+	}
+	template<typename T>
+	inline bool OneShot<T>::waitUntil(std::chrono::steady_clock::time_point deadline)
+	{
+		return detail::waitOnWord(&this->m_state, waiterBit, [](int32_t state) { return (state & readyBit) != 0; }, deadline);
+	}
+
+
+	template<typename T>
+	inline OneShot<T>::OneShot()
+	: m_state(0), m_continuation(nullptr), m_context(nullptr) {}
+	template<typename T>
+	inline OneShot<T>::~OneShot()
+	{
+		if(this->isReady()) this->value()->~T();
+	}
+
+
+	//platform: linux
+	#ifdef FTS_PLATFORM_LINUX
+		//=========================================PollableSignal=========================================
+		inline void PollableSignal::wake()
+		{
+			if((this->m_state.load(std::memory_order_relaxed) & wokenBit) != 0) return;
+			auto prev = this->m_state.fetch_or(wokenBit, std::memory_order_acq_rel);
+			if((prev & (wokenBit | sleepingBit)) == sleepingBit) [[unlikely]] detail::eventfdWrite(this->m_fd, 1);
+		}
+		inline bool PollableSignal::tryWait()
+		{
+			if(this->m_state.load(std::memory_order_relaxed) == 0) return false;
+			auto prev = this->m_state.exchange(0, std::memory_order_acquire);
+			//a wake that saw the loop sleeping may still be writing, a late write is drained after the next prepareWait()
+			if((prev & sleepingBit) != 0) detail::eventfdRead(this->m_fd);
+			return (prev & wokenBit) != 0;
+		}
+		inline void PollableSignal::wait()
+		{
+			for(int32_t i = 0; i < detail::adaptiveSpinCount; i++)
+			{
+				if(this->tryWait()) return;
+				detail::cpuRelax();
+			}
+			while(!this->tryWait())
+			{
+				if(this->prepareWait()) detail::pollIn(this->m_fd);
+			}
+		}
+		
+		inline bool PollableSignal::prepareWait()
+		{
+			auto state = this->m_state.load(std::memory_order_relaxed);
+			while((state & wokenBit) == 0)
+			{
+				if((state & sleepingBit) != 0 || this->m_state.compare_exchange_weak(state, state | sleepingBit, std::memory_order_acq_rel, std::memory_order_relaxed)) return true;
+			}
+			return false;
+		}
+		inline int PollableSignal::fd() const
+		{
+			return this->m_fd;
+		}
+
+
+		//=========================================PollableSemaphore=========================================
+		inline void PollableSemaphore::acquire()
+		{
+			for(int32_t i = 0; i < detail::adaptiveSpinCount; i++)
+			{
+				if(this->tryAcquire()) return;
+				detail::cpuRelax();
+			}
+			if(!this->prepareWait()) return;
+			while(!this->finishWait()) detail::pollIn(this->m_fd);
+		}
+		inline bool PollableSemaphore::tryAcquire()
+		{
+			auto count = this->m_count.load(std::memory_order_relaxed);
+			while(count > 0)
+			{
+				if(this->m_count.compare_exchange_weak(count, count - 1, std::memory_order_acquire, std::memory_order_relaxed)) return true;
+			}
+			return false;
+		}
+		inline void PollableSemaphore::release(int32_t n)
+		{
+			auto prev = this->m_count.fetch_add(n, std::memory_order_release);
+			if(prev < 0) [[unlikely]] detail::eventfdWrite(this->m_fd, static_cast<uint64_t>(std::min(-prev, n)));
+		}
+		
+		inline bool PollableSemaphore::prepareWait()
+		{
+			return this->m_count.fetch_sub(1, std::memory_order_acquire) <= 0;
+		}
+		inline bool PollableSemaphore::finishWait()
+		{
+			if(detail::eventfdRead(this->m_fd) == 0) return false;
+			std::atomic_thread_fence(std::memory_order_acquire);
+			return true;
+		}
+		inline bool PollableSemaphore::cancelWait()
+		{
+			auto count = this->m_count.load(std::memory_order_relaxed);
+			while(count < 0)
+			{
+				if(this->m_count.compare_exchange_weak(count, count + 1, std::memory_order_relaxed, std::memory_order_relaxed)) return false;
+			}
+			//a release() has already counted this thread as woken so its write to the eventfd is on the way
+			while(!this->finishWait()) detail::pollIn(this->m_fd);
+			return true;
+		}
+		inline int PollableSemaphore::fd() const
+		{
+			return this->m_fd;
+		}
+	#endif
+
+
+	//=========================================waitAny=========================================
+	inline void detail::notifyWaitAny()
+	{
+		//only called on the slow path of a wake, pairs with the fence after a fallback waiter registers itself
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if(detail::waitAnyFallbackUsers.load(std::memory_order_relaxed) > 0) [[unlikely]] detail::waitAnyEventCount().notifyAll();
+	}
+	inline EventCount& detail::waitAnyEventCount()
+	{
+		static EventCount eventCount;
+		return eventCount;
+	}
+
+	template<typename... WaitableT>
+	inline size_t waitAny(WaitableT&... waitables)
+	{
+		static_assert(sizeof...(WaitableT) > 0 && sizeof...(WaitableT) <= 128, "futex_waitv takes at most 128 futex words");
+		const detail::WaitAnySource sources[] = {
+			detail::WaitAnySource{
+				&waitables,
+				[](void* object) { return static_cast<WaitableT*>(object)->tryWait(); },
+				[](void* object) { return static_cast<WaitableT*>(object)->futexWord(); },
+				[](void* object, int32_t& expected) { return static_cast<WaitableT*>(object)->armWait(expected); },
+				[](void* object) { static_cast<WaitableT*>(object)->disarmWait(); }
+			}...
+		};
+		return detail::waitAny(sources, sizeof...(WaitableT));
+	}
+
+
+	//=========================================SNZI=========================================
+
+	inline void SNZI::arrive()
+	{
+		this->arrive(this->m_firstLeaf + (detail::threadIndex() % this->m_numLeaves));
+	}
+	inline void SNZI::depart()
+	{
+		this->depart(this->m_firstLeaf + (detail::threadIndex() % this->m_numLeaves));
+	}
+	inline bool SNZI::query() const
+	{
+		return this->m_root.load(std::memory_order_seq_cst) != 0;
+	}
+	inline std::atomic_int32_t& SNZI::indicator()
+	{
+		return this->m_root;
+	}
+
+	inline void SNZI::arrive(uint32_t node)
+	{
+		if(node == rootIndex)
+		{
+			this->m_root.fetch_add(1, std::memory_order_seq_cst);
+			return;
+		}
+
+		auto& state = this->m_nodes[node].state;
+		auto parent = this->m_nodes[node].parent;
+		uint32_t undoArrivals = 0;
+		auto succeeded = false;
+		while(!succeeded)
+		{
+			auto value = state.load(std::memory_order_seq_cst);
+			if((value & countMask) >= one)
+			{
+				if(state.compare_exchange_strong(value, value + 1, std::memory_order_seq_cst)) succeeded = true;
+			}
+			else if((value & countMask) == 0)
+			{
+				//take the node to half and announce it with a new version, then arrive at the parent before finishing
+				auto halfValue = (value & ~countMask) + version + half;
+				if(state.compare_exchange_strong(value, halfValue, std::memory_order_seq_cst))
+				{
+					succeeded = true;
+					value = halfValue;
+				}
+			}
+			if((value & countMask) == half)
+			{
+				//help whoever set half, if someone else already finished the transition our parent arrival is surplus
+				this->arrive(parent);
+				if(!state.compare_exchange_strong(value, (value & ~countMask) + one, std::memory_order_seq_cst)) undoArrivals++;
+			}
+		}
+		for(; undoArrivals > 0; undoArrivals--) this->depart(parent);
+	}
+	inline void SNZI::depart(uint32_t node)
+	{
+		if(node == rootIndex)
+		{
+			this->m_root.fetch_sub(1, std::memory_order_seq_cst);
+			return;
+		}
+
+		auto& state = this->m_nodes[node].state;
+		auto value = state.load(std::memory_order_seq_cst);
+		while(true)
+		{
+			//one goes straight back to zero, never to half
+			auto isLast = (value & countMask) == one;
+			if(state.compare_exchange_weak(value, isLast ? (value & ~countMask) : value - 1, std::memory_order_seq_cst))
+			{
+				if(isLast) this->depart(this->m_nodes[node].parent);
+				return;
+			}
+		}
+	}
+
+
+	//=========================================WaitPolicy=========================================
+
+	inline void SpinWaitPolicy::Waiters::wait(std::atomic_int32_t& address, int32_t value)
+	{
+		while(address.load(std::memory_order_relaxed) == value) detail::cpuRelax();
+	}
+	inline void SpinWaitPolicy::Waiters::wakeAll(std::atomic_int32_t& /*address*/)
+	{
+		return;
 	}
 
-	inline bool Signal::hasWaitingThread()
+	inline void AdaptiveWaitPolicy::Waiters::wait(std::atomic_int32_t& address, int32_t value)
 	{
-		return this->m_numWaiting.load() > 0;
+		for(int32_t i = 0; i < detail::adaptiveSpinCount; i++)
+		{
+			if(address.load(std::memory_order_relaxed) != value) return;
+			detail::cpuRelax();
+		}
+		//pairs with the load in wakeAll, either the waker sees this thread or the futex sees the new value
+		this->m_numSleeping.fetch_add(1, std::memory_order_seq_cst);
+		detail::futexWait(&address, value);
+		this->m_numSleeping.fetch_sub(1, std::memory_order_relaxed);
+	}
+	inline void AdaptiveWaitPolicy::Waiters::wakeAll(std::atomic_int32_t& address)
+	{
+		if(this->m_numSleeping.load(std::memory_order_seq_cst) != 0) [[unlikely]]
+		{
+			detail::futexWake(&address, std::numeric_limits<int32_t>::max());
+		}
 	}
 
 
-	//=========================================SpinSignal=========================================
-	inline void SpinSignal::wait()
+	//=========================================BasicReadWriteLock=========================================
+
+	template<typename Preference, typename WaitPolicy, typename ReaderTracking>
+	inline BasicReadWriteLock<Preference, WaitPolicy, ReaderTracking>::BasicReadWriteLock()
+	: m_state(0), m_waiters(), m_readers() {}
+
+	template<typename Preference, typename WaitPolicy, typename ReaderTracking>
+	inline void BasicReadWriteLock<Preference, WaitPolicy, ReaderTracking>::readLock()
 	{
-		this->m_isWaiting.store(2, std::memory_order_release);
 		while(true)
 		{
-			if(this->m_isWaiting.load(std::memory_order_relaxed) == 1)
+			if(this->enterRead()) [[likely]] return;
+
+			auto state = this->m_state.load(std::memory_order_relaxed);
+			while(state & writer)
 			{
-				this->m_isWaiting.fetch_add(1, std::memory_order_acquire);
-				return;
+				this->m_waiters.wait(this->m_state, state);
+				state = this->m_state.load(std::memory_order_relaxed);
 			}
-			else if(this->m_isWaiting.load(std::memory_order_relaxed) == 0)
+		}
+	}
+	template<typename Preference, typename WaitPolicy, typename ReaderTracking>
+	inline void BasicReadWriteLock<Preference, WaitPolicy, ReaderTracking>::writeLock()
+	{
+		if constexpr(std::is_same_v<Preference, WriterPreference>)
+		{
+			//raise the writer bit straight away to block new readers, then wait for the current ones to leave
+			auto state = this->m_state.load(std::memory_order_relaxed);
+			while(true)
 			{
-				return;
+				if(!(state & writer))
+				{
+					if(this->m_state.compare_exchange_weak(state, state | writer, std::memory_order_seq_cst)) [[likely]] break;
+				}
+				else
+				{
+					this->m_waiters.wait(this->m_state, state);
+					state = this->m_state.load(std::memory_order_relaxed);
+				}
+			}
+			this->waitForReaders();
+		}
+		else
+		{
+			//only take the lock once nobody is reading
+			while(true)
+			{
+				auto state = this->m_state.load(std::memory_order_relaxed);
+				while(state != 0)
+				{
+					this->m_waiters.wait(this->m_state, state);
+					state = this->m_state.load(std::memory_order_relaxed);
+				}
+				if(this->m_state.compare_exchange_weak(state, writer, std::memory_order_seq_cst))
+				{
+					if constexpr(!usesSNZI) return;
+					else
+					{
+						if(!this->m_readers.query()) [[likely]] return;
+						//readers arrived first, let them carry on
+						this->writeUnlock();
+						this->waitForReaders();
+					}
+				}
 			}
 		}
 	}
-	inline void SpinSignal::wake()
+	template<typename Preference, typename WaitPolicy, typename ReaderTracking>
+	inline void BasicReadWriteLock<Preference, WaitPolicy, ReaderTracking>::readUnlock()
 	{
-		this->m_isWaiting.store(1, std::memory_order_release);
+		if constexpr(usesSNZI)
+		{
+			this->m_readers.depart();
+			this->m_waiters.wakeAll(this->m_readers.indicator());
+		}
+		else
+		{
+			auto prev = this->m_state.fetch_sub(reader, std::memory_order_release);
+			//the last reader out lets a waiting writer in
+			if((prev & ~writer) == reader) this->m_waiters.wakeAll(this->m_state);
+		}
 	}
-	inline void SpinSignal::wakeAll()
+	template<typename Preference, typename WaitPolicy, typename ReaderTracking>
+	inline void BasicReadWriteLock<Preference, WaitPolicy, ReaderTracking>::writeUnlock()
 	{
-		this->m_isWaiting.store(0, std::memory_order_release);
+		//readers may be briefly incrementing and decrementing the state so it cannot simply be stored
+		this->m_state.fetch_sub(writer, std::memory_order_release);
+		this->m_waiters.wakeAll(this->m_state);
+	}
+	template<typename Preference, typename WaitPolicy, typename ReaderTracking>
+	inline bool BasicReadWriteLock<Preference, WaitPolicy, ReaderTracking>::readTryLock()
+	{
+		return this->enterRead();
+	}
+	template<typename Preference, typename WaitPolicy, typename ReaderTracking>
+	inline bool BasicReadWriteLock<Preference, WaitPolicy, ReaderTracking>::writeTryLock()
+	{
+		int32_t expected = 0;
+		if(!this->m_state.compare_exchange_strong(expected, writer, std::memory_order_seq_cst)) return false;
+		if constexpr(usesSNZI)
+		{
+			if(this->m_readers.query())
+			{
+				this->writeUnlock();
+				return false;
+			}
+		}
+		return true;
 	}
 
-	inline bool SpinSignal::hasWaitingThread()
+	template<typename Preference, typename WaitPolicy, typename ReaderTracking>
+	inline bool BasicReadWriteLock<Preference, WaitPolicy, ReaderTracking>::enterRead()
 	{
-		return this->m_isWaiting.load() > 0;
+		if constexpr(usesSNZI)
+		{
+			//arriving then checking the writer bit pairs with the writer setting its bit then querying the indicator
+			this->m_readers.arrive();
+			if(!(this->m_state.load(std::memory_order_seq_cst) & writer)) [[likely]] return true;
+		}
+		else
+		{
+			if(!(this->m_state.fetch_add(reader, std::memory_order_acquire) & writer)) [[likely]] return true;
+		}
+		this->readUnlock();
+		return false;
+	}
+	template<typename Preference, typename WaitPolicy, typename ReaderTracking>
+	inline void BasicReadWriteLock<Preference, WaitPolicy, ReaderTracking>::waitForReaders()
+	{
+		if constexpr(usesSNZI)
+		{
+			auto& indicator = this->m_readers.indicator();
+			auto state = indicator.load(std::memory_order_acquire);
+			while(state != 0)
+			{
+				this->m_waiters.wait(indicator, state);
+				state = indicator.load(std::memory_order_acquire);
+			}
+		}
+		else
+		{
+			auto state = this->m_state.load(std::memory_order_acquire);
+			while(state != writer)
+			{
+				this->m_waiters.wait(this->m_state, state);
+				state = this->m_state.load(std::memory_order_acquire);
+			}
+		}
 	}
 
 
-	//=========================================flag=========================================
-	inline void Flag::raise()
+	template<typename WaitPolicy, typename ReaderTracking>
+	inline BasicReadWriteLock<PhaseFairPreference, WaitPolicy, ReaderTracking>::BasicReadWriteLock()
+	: m_readersIn(0), m_readersOut(0), m_writersIn(0), m_writersOut(0), m_waiters() {}
+
+	template<typename WaitPolicy, typename ReaderTracking>
+	inline void BasicReadWriteLock<PhaseFairPreference, WaitPolicy, ReaderTracking>::readLock()
 	{
-		this->m_isRaised.store(true);
+		//readers that arrive during a write phase only wait for that one writer to leave, a writer that arrives after them has a different phase bit
+		auto writerState = this->m_readersIn.fetch_add(readerIncrement, std::memory_order_acquire) & writerBits;
+		if(writerState != 0) [[unlikely]]
+		{
+			auto state = this->m_readersIn.load(std::memory_order_acquire);
+			while((state & writerBits) == writerState)
+			{
+				this->m_waiters.wait(this->m_readersIn, state);
+				state = this->m_readersIn.load(std::memory_order_acquire);
+			}
+		}
 	}
-	inline void Flag::lower()
+	template<typename WaitPolicy, typename ReaderTracking>
+	inline void BasicReadWriteLock<PhaseFairPreference, WaitPolicy, ReaderTracking>::writeLock()
+	{
+		auto ticket = this->m_writersIn.fetch_add(1, std::memory_order_relaxed);
+		auto state = this->m_writersOut.load(std::memory_order_acquire);
+		while(state != ticket)
+		{
+			this->m_waiters.wait(this->m_writersOut, state);
+			state = this->m_writersOut.load(std::memory_order_acquire);
+		}
+
+		//block new readers and wait for the readers of the current read phase to drain
+		auto readTicket = this->m_readersIn.fetch_add(writerPresent | (ticket & writerPhase), std::memory_order_acquire);
+		state = this->m_readersOut.load(std::memory_order_acquire);
+		while(state != readTicket)
+		{
+			this->m_waiters.wait(this->m_readersOut, state);
+			state = this->m_readersOut.load(std::memory_order_acquire);
+		}
+	}
+	template<typename WaitPolicy, typename ReaderTracking>
+	inline void BasicReadWriteLock<PhaseFairPreference, WaitPolicy, ReaderTracking>::readUnlock()
 	{
-		this->m_isRaised.store(false);
+		this->m_readersOut.fetch_add(readerIncrement, std::memory_order_release);
+		this->m_waiters.wakeAll(this->m_readersOut);
 	}
-	inline bool Flag::isRaised()
+	template<typename WaitPolicy, typename ReaderTracking>
+	inline void BasicReadWriteLock<PhaseFairPreference, WaitPolicy, ReaderTracking>::writeUnlock()
+	{
+		this->m_readersIn.fetch_and(~writerBits, std::memory_order_release);
+		this->m_waiters.wakeAll(this->m_readersIn);
+		this->m_writersOut.fetch_add(1, std::memory_order_release);
+		this->m_waiters.wakeAll(this->m_writersOut);
+	}
+	template<typename WaitPolicy, typename ReaderTracking>
+	inline bool BasicReadWriteLock<PhaseFairPreference, WaitPolicy, ReaderTracking>::readTryLock()
 	{
-		return this->m_isRaised.load();
+		//only enter while no writer is present, a writer's drain ticket counts neither this reader's arrival nor its departure
+		auto state = this->m_readersIn.load(std::memory_order_relaxed);
+		while((state & writerBits) == 0)
+		{
+			if(this->m_readersIn.compare_exchange_weak(state, state + readerIncrement, std::memory_order_acquire, std::memory_order_relaxed)) return true;
+		}
+		return false;
+	}
+	template<typename WaitPolicy, typename ReaderTracking>
+	inline bool BasicReadWriteLock<PhaseFairPreference, WaitPolicy, ReaderTracking>::writeTryLock()
+	{
+		auto ticket = this->m_writersOut.load(std::memory_order_acquire);
+		if(!this->m_writersIn.compare_exchange_strong(ticket, ticket + 1, std::memory_order_relaxed)) return false;
+
+		auto readTicket = this->m_readersIn.fetch_add(writerPresent | (ticket & writerPhase), std::memory_order_acquire);
+		if(this->m_readersOut.load(std::memory_order_acquire) != readTicket)
+		{
+			//readers are still active, back out the same way as a write unlock
+			this->writeUnlock();
+			return false;
+		}
+		return true;
 	}
 
 
-	//=========================================ReadWriteLock=========================================
+	//=========================================UpgradeableRWLock=========================================
 
-	inline void ReadWriteLock::readLock()
+	inline void UpgradeableRWLock::readLock()
+	{
+		while(true)
+		{
+			if(!(this->m_state.fetch_add(reader, std::memory_order_acquire) & writer)) [[likely]] break;
+			this->m_state.fetch_sub(reader, std::memory_order_relaxed);
+			while(this->m_state.load(std::memory_order_relaxed) & writer);
+		}
+	}
+	inline void UpgradeableRWLock::writeLock()
 	{
 		while(true)
 		{
-			if(!this->m_writeRequest.load(std::memory_order_relaxed)) [[likely]] break;
-			while(this->m_writeRequest.load(std::memory_order_relaxed));
+			auto state = this->m_state.load(std::memory_order_relaxed);
+			if(!(state & (writer | upgrader)) && this->m_state.compare_exchange_weak(state, state | writer, std::memory_order_acquire)) [[likely]] break;
+			while(this->m_state.load(std::memory_order_relaxed) & (writer | upgrader));
 		}
-		this->m_numReaders.fetch_add(1, std::memory_order_acquire);
+		//new readers back off once the writer bit is set, wait for the existing ones to leave
+		while(this->m_state.load(std::memory_order_acquire) & ~(writer | upgrader));
 	}
-	inline void ReadWriteLock::writeLock()
+	inline void UpgradeableRWLock::upgradeLock()
 	{
 		while(true)
 		{
-			if((!this->m_writeRequest.exchange(true, std::memory_order_acquire)) && (this->m_numReaders.load(std::memory_order_relaxed) == 0)) [[likely]] break;
-			while(this->m_writeRequest.load(std::memory_order_relaxed));
-			while(this->m_numReaders.load(std::memory_order_relaxed) != 0);
+			auto state = this->m_state.load(std::memory_order_relaxed);
+			if(!(state & (writer | upgrader)) && this->m_state.compare_exchange_weak(state, state | upgrader, std::memory_order_acquire)) [[likely]] break;
+			while(this->m_state.load(std::memory_order_relaxed) & (writer | upgrader));
 		}
 	}
-	inline void ReadWriteLock::readUnlock()
+	inline void UpgradeableRWLock::readUnlock()
+	{
+		this->m_state.fetch_sub(reader, std::memory_order_release);
+	}
+	inline void UpgradeableRWLock::writeUnlock()
 	{
-		this->m_numReaders.fetch_sub(1, std::memory_order_acquire);
+		//readers may be briefly incrementing and decrementing the state so it cannot simply be stored
+		this->m_state.fetch_sub(writer, std::memory_order_release);
 	}
-	inline void ReadWriteLock::writeUnlock()
+	inline void UpgradeableRWLock::upgradeUnlock()
 	{
-		this->m_writeRequest.store(false, std::memory_order_release);
+		this->m_state.fetch_sub(upgrader, std::memory_order_release);
 	}
-	inline bool ReadWriteLock::readTryLock()
+	inline bool UpgradeableRWLock::readTryLock()
 	{
-		if(!this->m_writeRequest.load(std::memory_order_relaxed)) [[likely]]
+		if(!(this->m_state.fetch_add(reader, std::memory_order_acquire) & writer)) [[likely]] return true;
+		this->m_state.fetch_sub(reader, std::memory_order_relaxed);
+		return false;
+	}
+	inline bool UpgradeableRWLock::writeTryLock()
+	{
+		int32_t expected = 0;
+		return this->m_state.compare_exchange_strong(expected, writer, std::memory_order_acquire);
+	}
+	inline bool UpgradeableRWLock::upgradeTryLock()
+	{
+		auto state = this->m_state.load(std::memory_order_relaxed);
+		while(!(state & (writer | upgrader)))
 		{
-			this->m_numReaders.fetch_add(1, std::memory_order_acquire);
-			return true;
+			if(this->m_state.compare_exchange_weak(state, state | upgrader, std::memory_order_acquire)) return true;
+		}
+		return false;
+	}
+
+	inline void UpgradeableRWLock::upgrade()
+	{
+		//holding the upgrader bit keeps every other writer out so the writer bit can be taken unconditionally
+		this->m_state.fetch_add(writer, std::memory_order_acquire);
+		while(this->m_state.load(std::memory_order_acquire) & ~(writer | upgrader));
+		this->m_state.fetch_sub(upgrader, std::memory_order_relaxed);
+	}
+	inline void UpgradeableRWLock::downgrade()
+	{
+		//writer -> upgrader in a single step
+		this->m_state.fetch_add(upgrader - writer, std::memory_order_release);
+	}
+
+
+	//=========================================OptLock=========================================
+
+	inline uint64_t OptLock::readLockOrRestart(bool& needRestart) const
+	{
+		auto version = this->m_version.load(std::memory_order_acquire);
+		if(version & (locked | obsolete)) [[unlikely]]
+		{
+			detail::cpuRelax();
+			needRestart = true;
+		}
+		return version;
+	}
+	inline void OptLock::checkOrRestart(uint64_t version, bool& needRestart) const
+	{
+		//seqlock style validation, the fence keeps the optimistic reads before the version load
+		std::atomic_thread_fence(std::memory_order_acquire);
+		needRestart = version != this->m_version.load(std::memory_order_relaxed);
+	}
+	inline void OptLock::readUnlockOrRestart(uint64_t version, bool& needRestart) const
+	{
+		this->checkOrRestart(version, needRestart);
+	}
+	inline void OptLock::upgradeToWriteLockOrRestart(uint64_t& version, bool& needRestart)
+	{
+		if(this->m_version.compare_exchange_strong(version, version + locked, std::memory_order_acquire)) [[likely]]
+		{
+			version = version + locked;
+			//keeps the writes of the critical section after the lock bit for optimistic readers
+			std::atomic_thread_fence(std::memory_order_release);
 		}
 		else
 		{
-			return false;
+			detail::cpuRelax();
+			needRestart = true;
 		}
 	}
-	inline bool ReadWriteLock::writeTryLock()
+	inline void OptLock::writeLockOrRestart(bool& needRestart)
+	{
+		auto version = this->readLockOrRestart(needRestart);
+		if(needRestart) return;
+		this->upgradeToWriteLockOrRestart(version, needRestart);
+	}
+	inline void OptLock::writeUnlock()
+	{
+		//clears the lock bit and carries into the version
+		this->m_version.fetch_add(locked, std::memory_order_release);
+	}
+	inline void OptLock::writeUnlockObsolete()
 	{
-		if((!this->m_writeRequest.exchange(true, std::memory_order_acquire)) && (this->m_numReaders.load(std::memory_order_relaxed) == 0)) [[likely]]
+		this->m_version.fetch_add(locked | obsolete, std::memory_order_release);
+	}
+	inline bool OptLock::isLocked() const
+	{
+		return (this->m_version.load(std::memory_order_relaxed) & locked) != 0;
+	}
+
+
+	//=========================================LeftRight=========================================
+
+	inline void detail::ReadIndicator::arrive()
+	{
+		this->m_counters[detail::threadIndex() % this->m_numCounters].count.fetch_add(1, std::memory_order_seq_cst);
+	}
+	inline void detail::ReadIndicator::depart()
+	{
+		this->m_counters[detail::threadIndex() % this->m_numCounters].count.fetch_sub(1, std::memory_order_release);
+	}
+	inline bool detail::ReadIndicator::isEmpty() const
+	{
+		for(uint32_t i = 0; i < this->m_numCounters; i++)
 		{
-			return true;
+			if(this->m_counters[i].count.load(std::memory_order_seq_cst) != 0) return false;
+		}
+		return true;
+	}
+
+	template<typename T>
+	template<typename... Args>
+	inline LeftRight<T>::LeftRight(const Args&... args)
+	: m_instances{T(args...), T(args...)}, m_leftRight(0), m_versionIndex(0), m_readIndicators(), m_writerLock() {}
+
+	template<typename T>
+	template<typename ReaderT>
+	inline std::invoke_result_t<ReaderT, const T&> LeftRight<T>::read(ReaderT&& reader) const
+	{
+		class Departure
+		{
+			public:
+				explicit Departure(detail::ReadIndicator& readIndicator) : m_readIndicator(readIndicator) {}
+				~Departure() { this->m_readIndicator.depart(); }
+			private:
+				detail::ReadIndicator& m_readIndicator;
+		};
+
+		auto& readIndicator = this->m_readIndicators[this->m_versionIndex.load(std::memory_order_seq_cst)];
+		readIndicator.arrive();
+		Departure departure(readIndicator);
+		return std::forward<ReaderT>(reader)(this->m_instances[this->m_leftRight.load(std::memory_order_seq_cst)]);
+	}
+	template<typename T>
+	template<typename WriterT>
+	inline void LeftRight<T>::modify(WriterT&& writer)
+	{
+		GenericLockGuard<SpinLock> lock(this->m_writerLock);
+		auto leftRight = this->m_leftRight.load(std::memory_order_relaxed);
+		//readers are only ever on the other copy, after switching them over and waiting they have all left this one
+		writer(this->m_instances[1 - leftRight]);
+		this->m_leftRight.store(1 - leftRight, std::memory_order_seq_cst);
+		this->toggleVersionAndWait();
+		writer(this->m_instances[leftRight]);
+	}
+
+	template<typename T>
+	inline void LeftRight<T>::toggleVersionAndWait()
+	{
+		auto waitForEmpty = [](const detail::ReadIndicator& readIndicator)
+		{
+			for(uint32_t attempt = 0; !readIndicator.isEmpty(); attempt++)
+			{
+				if(attempt < detail::adaptiveSpinCount) detail::cpuRelax();
+				else std::this_thread::yield();
+			}
+		};
+
+		auto prevVersion = this->m_versionIndex.load(std::memory_order_relaxed);
+		auto nextVersion = 1 - prevVersion;
+		//readers still arriving on the next indicator from an earlier toggle have to leave before it is reused
+		waitForEmpty(this->m_readIndicators[nextVersion]);
+		this->m_versionIndex.store(nextVersion, std::memory_order_seq_cst);
+		waitForEmpty(this->m_readIndicators[prevVersion]);
+	}
+
+
+	//=========================================rcu=========================================
+
+	inline rcu::detail::ThreadRecord& rcu::detail::threadRecord()
+	{
+		thread_local ThreadRegistration registration;
+		return *registration.record;
+	}
+
+	inline void rcu::readLock()
+	{
+		auto& record = detail::threadRecord();
+		auto counter = record.counter.load(std::memory_order_relaxed);
+		if((counter & detail::nestMask) == 0) [[likely]]
+		{
+			//outermost critical section, take a snapshot of the current phase with a nesting depth of one
+			record.counter.store(detail::globalCounter.load(std::memory_order_relaxed), std::memory_order_relaxed);
+			fts::detail::asymmetricLightFence();
 		}
 		else
 		{
-			return false;
+			record.counter.store(counter + 1, std::memory_order_relaxed);
+		}
+	}
+	inline void rcu::readUnlock()
+	{
+		auto& record = detail::threadRecord();
+		fts::detail::asymmetricLightFence();
+		record.counter.store(record.counter.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+	}
+
+	inline rcu::ReadLockGuard::ReadLockGuard()
+	{
+		rcu::readLock();
+	}
+	inline rcu::ReadLockGuard::~ReadLockGuard()
+	{
+		rcu::readUnlock();
+	}
+
+
+	//=========================================HazardPointerDomain=========================================
+
+	template<typename T>
+	inline T* HazardPointerDomain::protect(const std::atomic<T*>& source, uint32_t slot)
+	{
+		auto& hazard = this->threadRecord().hazards[slot];
+		auto pointer = source.load(std::memory_order_relaxed);
+		while(true)
+		{
+			//the heavy fence in scan() makes this store visible before the hazards are read, so a plain store is enough
+			hazard.store(pointer, std::memory_order_relaxed);
+			detail::asymmetricLightFence();
+			auto current = source.load(std::memory_order_acquire);
+			if(current == pointer) return pointer;
+			pointer = current;
+		}
+	}
+	inline void HazardPointerDomain::clear(uint32_t slot)
+	{
+		this->threadRecord().hazards[slot].store(nullptr, std::memory_order_release);
+	}
+	inline void HazardPointerDomain::clearAll()
+	{
+		for(auto& hazard : this->threadRecord().hazards) hazard.store(nullptr, std::memory_order_release);
+	}
+	template<typename T, typename DeleterT>
+	inline void HazardPointerDomain::retire(T* pointer, DeleterT deleter)
+	{
+		auto& record = this->threadRecord();
+		record.retired.emplace_back(static_cast<void*>(pointer), [pointer, deleter = std::move(deleter)]() mutable { deleter(pointer); });
+		//amortise each scan over a batch at least twice the number of hazards so most of it is freed every time
+		auto threshold = std::max<size_t>(64, 2 * numSlots * static_cast<size_t>(this->m_numRecords.load(std::memory_order_relaxed)));
+		if(record.retired.size() >= threshold) this->scan(record);
+	}
+
+	inline detail::HazardRecord& HazardPointerDomain::threadRecord()
+	{
+		auto record = detail::threadRecords().find(this);
+		if(record != nullptr) [[likely]] return *static_cast<detail::HazardRecord*>(record);
+		return this->acquireRecord();
+	}
+
+
+	//=========================================EpochDomain=========================================
+
+	inline EpochDomain::Guard::Guard(EpochDomain& domain)
+	: m_domain(domain)
+	{
+		this->m_domain.enter();
+	}
+	inline EpochDomain::Guard::~Guard()
+	{
+		this->m_domain.exit();
+	}
+
+	inline EpochDomain::Guard EpochDomain::guard()
+	{
+		return Guard(*this);
+	}
+	inline void EpochDomain::enter()
+	{
+		auto& record = this->threadRecord();
+		if(record.nesting++ != 0) return;
+		auto epoch = this->m_epoch.load(std::memory_order_relaxed);
+		record.announcement.store((epoch << 1) | detail::EpochRecord::active, std::memory_order_relaxed);
+		//pairs with the heavy fence in tryAdvance(), the announcement is visible before anything in the traversal is read
+		detail::asymmetricLightFence();
+	}
+	inline void EpochDomain::exit()
+	{
+		auto& record = this->threadRecord();
+		if(--record.nesting == 0) record.announcement.store(0, std::memory_order_release);
+	}
+	template<typename T, typename DeleterT>
+	inline void EpochDomain::retire(T* pointer, DeleterT deleter)
+	{
+		auto& record = this->threadRecord();
+		auto epoch = this->m_epoch.load(std::memory_order_seq_cst);
+		auto index = static_cast<uint32_t>(epoch % 3);
+		//a list tagged with an older epoch of the same index is at least three epochs old and safe to free
+		if(record.limboEpochs[index] != epoch)
+		{
+			EpochDomain::freeLimbo(record, index);
+			record.limboEpochs[index] = epoch;
 		}
+		record.limbo[index].emplace_back([pointer, deleter = std::move(deleter)]() mutable { deleter(pointer); });
+		if(++record.numRetired >= advanceInterval) this->reclaim(record);
+	}
+
+	inline detail::EpochRecord& EpochDomain::threadRecord()
+	{
+		auto record = detail::threadRecords().find(this);
+		if(record != nullptr) [[likely]] return *static_cast<detail::EpochRecord*>(record);
+		return this->acquireRecord();
 	}
 
 	
@@ -489,32 +2442,102 @@ namespace fts
 		this->m_semaphore->unlockDestoryCounter();
 	}
 
-	inline ReadWriteLockReadLockGuard::ReadWriteLockReadLockGuard(ReadWriteLock& readWriteLock)
+	inline UpgradeableRWLockReadLockGuard::UpgradeableRWLockReadLockGuard(UpgradeableRWLock& upgradeableRWLock)
+	{
+		this->m_upgradeableRWLock = &upgradeableRWLock;
+		this->m_upgradeableRWLock->readLock();
+	}
+	inline UpgradeableRWLockReadLockGuard::UpgradeableRWLockReadLockGuard(UpgradeableRWLock* upgradeableRWLock)
+	{
+		this->m_upgradeableRWLock = upgradeableRWLock;
+		this->m_upgradeableRWLock->readLock();
+	}
+	inline UpgradeableRWLockReadLockGuard::~UpgradeableRWLockReadLockGuard()
+	{
+		this->m_upgradeableRWLock->readUnlock();
+	}
+
+	inline UpgradeableRWLockWriteLockGuard::UpgradeableRWLockWriteLockGuard(UpgradeableRWLock& upgradeableRWLock)
+	{
+		this->m_upgradeableRWLock = &upgradeableRWLock;
+		this->m_upgradeableRWLock->writeLock();
+	}
+	inline UpgradeableRWLockWriteLockGuard::UpgradeableRWLockWriteLockGuard(UpgradeableRWLock* upgradeableRWLock)
+	{
+		this->m_upgradeableRWLock = upgradeableRWLock;
+		this->m_upgradeableRWLock->writeLock();
+	}
+	inline UpgradeableRWLockWriteLockGuard::~UpgradeableRWLockWriteLockGuard()
+	{
+		this->m_upgradeableRWLock->writeUnlock();
+	}
+
+	inline UpgradeableRWLockUpgradeLockGuard::UpgradeableRWLockUpgradeLockGuard(UpgradeableRWLock& upgradeableRWLock)
+	{
+		this->m_upgradeableRWLock = &upgradeableRWLock;
+		this->m_isUpgraded = false;
+		this->m_upgradeableRWLock->upgradeLock();
+	}
+	inline UpgradeableRWLockUpgradeLockGuard::UpgradeableRWLockUpgradeLockGuard(UpgradeableRWLock* upgradeableRWLock)
+	{
+		this->m_upgradeableRWLock = upgradeableRWLock;
+		this->m_isUpgraded = false;
+		this->m_upgradeableRWLock->upgradeLock();
+	}
+	inline UpgradeableRWLockUpgradeLockGuard::~UpgradeableRWLockUpgradeLockGuard()
+	{
+		if(this->m_isUpgraded) this->m_upgradeableRWLock->writeUnlock();
+		else this->m_upgradeableRWLock->upgradeUnlock();
+	}
+	inline void UpgradeableRWLockUpgradeLockGuard::upgrade()
+	{
+		if(!this->m_isUpgraded)
+		{
+			this->m_upgradeableRWLock->upgrade();
+			this->m_isUpgraded = true;
+		}
+	}
+	inline void UpgradeableRWLockUpgradeLockGuard::downgrade()
+	{
+		if(this->m_isUpgraded)
+		{
+			this->m_upgradeableRWLock->downgrade();
+			this->m_isUpgraded = false;
+		}
+	}
+
+	template<typename ReadWriteLockT>
+	inline ReadWriteLockReadLockGuard<ReadWriteLockT>::ReadWriteLockReadLockGuard(ReadWriteLockT& readWriteLock)
 	{
 		this->m_readWriteLock = &readWriteLock;
 		this->m_readWriteLock->readLock();
 	}
-	inline ReadWriteLockReadLockGuard::ReadWriteLockReadLockGuard(ReadWriteLock* readWriteLock)
+	template<typename ReadWriteLockT>
+	inline ReadWriteLockReadLockGuard<ReadWriteLockT>::ReadWriteLockReadLockGuard(ReadWriteLockT* readWriteLock)
 	{
 		this->m_readWriteLock = readWriteLock;
 		this->m_readWriteLock->readLock();
 	}
-	inline ReadWriteLockReadLockGuard::~ReadWriteLockReadLockGuard()
+	template<typename ReadWriteLockT>
+	inline ReadWriteLockReadLockGuard<ReadWriteLockT>::~ReadWriteLockReadLockGuard()
 	{
 		this->m_readWriteLock->readUnlock();
 	}
 
-	inline ReadWriteLockWriteLockGuard::ReadWriteLockWriteLockGuard(ReadWriteLock& readWriteLock)
+	template<typename ReadWriteLockT>
+	inline ReadWriteLockWriteLockGuard<ReadWriteLockT>::ReadWriteLockWriteLockGuard(ReadWriteLockT& readWriteLock)
 	{
 		this->m_readWriteLock = &readWriteLock;
 		this->m_readWriteLock->writeLock();
 	}
-	inline ReadWriteLockWriteLockGuard::ReadWriteLockWriteLockGuard(ReadWriteLock* readWriteLock)
+	template<typename ReadWriteLockT>
+	inline ReadWriteLockWriteLockGuard<ReadWriteLockT>::ReadWriteLockWriteLockGuard(ReadWriteLockT* readWriteLock)
 	{
 		this->m_readWriteLock = readWriteLock;
 		this->m_readWriteLock->writeLock();
 	}
-	inline ReadWriteLockWriteLockGuard::~ReadWriteLockWriteLockGuard()
+	template<typename ReadWriteLockT>
+	inline ReadWriteLockWriteLockGuard<ReadWriteLockT>::~ReadWriteLockWriteLockGuard()
 	{
 		this->m_readWriteLock->writeUnlock();
 	}
@@ -0,0 +1,70 @@
+#include "../../src/fts.hpp"
+#include <barrier>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <thread>
+#include <vector>
+
+//barrier latency against the number of threads for each algorithm and std::barrier. Every thread passes the barrier
+//the given number of times back to back, the time per phase is the whole run divided by the number of phases
+//usage: fts_bench_barrier [max threads] [phases]
+
+class StdBarrier
+{
+	public:
+		StdBarrier(uint32_t numThreads)
+		: m_barrier(static_cast<std::ptrdiff_t>(numThreads)) {}
+
+		void arriveAndWait(uint32_t)
+		{
+			this->m_barrier.arrive_and_wait();
+		}
+
+	private:
+		std::barrier<> m_barrier;
+};
+
+template<typename BarrierT, typename... Args>
+double runBenchmark(uint32_t numThreads, int numPhases, Args... args)
+{
+	BarrierT barrier(numThreads, args...);
+
+	std::atomic_bool start(false);
+	std::vector<std::thread> threads;
+	for(uint32_t t = 0; t < numThreads; t++)
+	{
+		threads.emplace_back([&, t]()
+		{
+			while(!start.load(std::memory_order_acquire));
+			for(int i = 0; i < numPhases; i++) barrier.arriveAndWait(t);
+		});
+	}
+
+	auto before = std::chrono::steady_clock::now();
+	start.store(true, std::memory_order_release);
+	for(auto& thread : threads) thread.join();
+	auto nanoseconds = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - before).count();
+	return nanoseconds / numPhases;
+}
+
+int main(int argc, const char** argv)
+{
+	uint32_t maxThreads = argc > 1 ? static_cast<uint32_t>(std::atoi(argv[1])) : std::max(1u, std::thread::hardware_concurrency());
+	int numPhases = argc > 2 ? std::atoi(argv[2]) : 10000;
+
+	std::cout << numPhases << " phases, ns per phase" << std::endl;
+	std::cout << std::setw(8) << "threads" << std::setw(16) << "SenseReversing" << std::setw(16) << "CombiningTree" << std::setw(16) << "Dissemination"
+		<< std::setw(16) << "std::barrier" << std::endl;
+	for(uint32_t numThreads = 1; ; numThreads = std::min(numThreads * 2, maxThreads))
+	{
+		std::cout << std::setw(8) << numThreads << std::fixed << std::setprecision(0)
+			<< std::setw(16) << runBenchmark<fts::Barrier>(numThreads, numPhases, fts::BarrierAlgorithm::SenseReversing)
+			<< std::setw(16) << runBenchmark<fts::Barrier>(numThreads, numPhases, fts::BarrierAlgorithm::CombiningTree)
+			<< std::setw(16) << runBenchmark<fts::Barrier>(numThreads, numPhases, fts::BarrierAlgorithm::Dissemination)
+			<< std::setw(16) << runBenchmark<StdBarrier>(numThreads, numPhases) << std::endl;
+		if(numThreads == maxThreads) break;
+	}
+
+	return 0;
+}
@@ -0,0 +1,90 @@
+#include "sample_btree.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <numeric>
+#include <random>
+#include <thread>
+#include <vector>
+
+//lookup throughput of the sample B+ trees, optimistic lock coupling against read write lock coupling
+//usage: fts_bench_btree [threads] [keys] [milliseconds]
+
+template<typename TreeT>
+void populate(TreeT& tree, const std::vector<sample::Key>& keys, unsigned numThreads)
+{
+	std::vector<std::thread> threads;
+	for(unsigned t = 0; t < numThreads; t++)
+	{
+		threads.emplace_back([&tree, &keys, t, numThreads]()
+		{
+			for(size_t i = t; i < keys.size(); i += numThreads) tree.insert(keys[i], keys[i] * 2);
+		});
+	}
+	for(auto& thread : threads) thread.join();
+}
+
+template<typename TreeT>
+void runBenchmark(const char* name, const std::vector<sample::Key>& keys, unsigned numThreads, int milliseconds)
+{
+	TreeT tree;
+	populate(tree, keys, numThreads);
+
+	std::atomic_bool start(false);
+	std::atomic_bool stop(false);
+	std::atomic_uint64_t totalLookups(0);
+	std::atomic_uint64_t totalMissing(0);
+	std::vector<std::thread> threads;
+	for(unsigned t = 0; t < numThreads; t++)
+	{
+		threads.emplace_back([&, t]()
+		{
+			std::mt19937_64 random(t);
+			uint64_t lookups = 0;
+			uint64_t missing = 0;
+			while(!start.load(std::memory_order_acquire));
+			while(!stop.load(std::memory_order_relaxed))
+			{
+				for(int i = 0; i < 64; i++)
+				{
+					auto key = keys[random() % keys.size()];
+					sample::Value value = 0;
+					if(!tree.lookup(key, value) || value != key * 2) missing++;
+				}
+				lookups += 64;
+			}
+			totalLookups.fetch_add(lookups);
+			totalMissing.fetch_add(missing);
+		});
+	}
+
+	auto before = std::chrono::steady_clock::now();
+	start.store(true, std::memory_order_release);
+	std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+	stop.store(true);
+	for(auto& thread : threads) thread.join();
+	auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - before).count();
+
+	std::cout << std::setw(20) << name << std::setw(16) << std::fixed << std::setprecision(2)
+		<< static_cast<double>(totalLookups.load()) / seconds / 1e6 << " M lookups/s";
+	if(totalMissing.load() != 0) std::cout << "  (" << totalMissing.load() << " lookups returned a wrong result)";
+	std::cout << std::endl;
+}
+
+int main(int argc, const char** argv)
+{
+	unsigned numThreads = argc > 1 ? static_cast<unsigned>(std::atoi(argv[1])) : std::max(1u, std::thread::hardware_concurrency());
+	size_t numKeys = argc > 2 ? static_cast<size_t>(std::atoll(argv[2])) : 1000000;
+	int milliseconds = argc > 3 ? std::atoi(argv[3]) : 1000;
+
+	std::vector<sample::Key> keys(numKeys);
+	std::iota(keys.begin(), keys.end(), 1);
+	std::shuffle(keys.begin(), keys.end(), std::mt19937_64(42));
+
+	std::cout << numThreads << " threads, " << numKeys << " keys" << std::endl;
+	runBenchmark<sample::OptimisticBTree>("OptLock coupling", keys, numThreads, milliseconds);
+	runBenchmark<sample::ReadWriteLockBTree>("ReadWriteLock coupling", keys, numThreads, milliseconds);
+
+	return 0;
+}
@@ -0,0 +1,155 @@
+#include "../../src/fts.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <random>
+#include <thread>
+#include <vector>
+
+//reclamation throughput and memory overhead of hazard pointers against epoch based reclamation. Threads read random
+//slots of a shared table and every so often replace a slot and retire the old node. The stalled run adds a thread that
+//protects a node or pins an epoch and then sleeps for the whole run
+//usage: fts_bench_reclamation [threads] [milliseconds]
+
+struct Node
+{
+	uint64_t value;
+	uint64_t padding[7];
+};
+
+constexpr size_t numSlots = 1024;
+//one write per this many reads
+constexpr uint32_t readsPerWrite = 16;
+
+std::atomic_int64_t numLive(0);
+//keeps the reads from being optimised out
+std::atomic_uint64_t checksumSink(0);
+
+Node* makeNode(uint64_t value)
+{
+	numLive.fetch_add(1, std::memory_order_relaxed);
+	return new Node{value, {}};
+}
+void deleteNode(Node* node)
+{
+	numLive.fetch_sub(1, std::memory_order_relaxed);
+	delete node;
+}
+
+class HazardPointerScheme
+{
+	public:
+		static constexpr const char* name = "HazardPointer";
+
+		uint64_t read(const std::atomic<Node*>& slot)
+		{
+			auto node = this->m_domain.protect(slot);
+			auto value = node->value;
+			this->m_domain.clear();
+			return value;
+		}
+		void replace(std::atomic<Node*>& slot, Node* node)
+		{
+			this->m_domain.retire(slot.exchange(node), &deleteNode);
+		}
+		void stall(const std::atomic<Node*>& slot, const std::atomic_bool& stop)
+		{
+			this->m_domain.protect(slot);
+			while(!stop.load(std::memory_order_relaxed)) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			this->m_domain.clear();
+		}
+
+	private:
+		fts::HazardPointerDomain m_domain;
+};
+
+class EpochScheme
+{
+	public:
+		static constexpr const char* name = "EpochDomain";
+
+		uint64_t read(const std::atomic<Node*>& slot)
+		{
+			auto guard = this->m_domain.guard();
+			return slot.load(std::memory_order_acquire)->value;
+		}
+		void replace(std::atomic<Node*>& slot, Node* node)
+		{
+			auto guard = this->m_domain.guard();
+			this->m_domain.retire(slot.exchange(node), &deleteNode);
+		}
+		void stall(const std::atomic<Node*>&, const std::atomic_bool& stop)
+		{
+			auto guard = this->m_domain.guard();
+			while(!stop.load(std::memory_order_relaxed)) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+
+	private:
+		fts::EpochDomain m_domain;
+};
+
+template<typename SchemeT>
+void runBenchmark(unsigned numThreads, int milliseconds, bool isStalled)
+{
+	SchemeT scheme;
+	std::vector<std::atomic<Node*>> slots(numSlots);
+	for(size_t i = 0; i < numSlots; i++) slots[i].store(makeNode(i));
+
+	std::atomic_bool start(false);
+	std::atomic_bool stop(false);
+	std::atomic_uint64_t totalOperations(0);
+	std::atomic_int64_t peakLive(0);
+	std::vector<std::thread> threads;
+	for(unsigned t = 0; t < numThreads; t++)
+	{
+		threads.emplace_back([&, t]()
+		{
+			std::mt19937_64 random(t);
+			uint64_t operations = 0;
+			uint64_t checksum = 0;
+			int64_t threadPeakLive = 0;
+			while(!start.load(std::memory_order_acquire));
+			while(!stop.load(std::memory_order_relaxed))
+			{
+				for(uint32_t i = 0; i < readsPerWrite; i++) checksum += scheme.read(slots[random() % numSlots]);
+				scheme.replace(slots[random() % numSlots], makeNode(operations));
+				operations += readsPerWrite + 1;
+				threadPeakLive = std::max(threadPeakLive, numLive.load(std::memory_order_relaxed));
+			}
+			totalOperations.fetch_add(operations);
+			checksumSink.fetch_add(checksum, std::memory_order_relaxed);
+			auto currentPeak = peakLive.load();
+			while(threadPeakLive > currentPeak && !peakLive.compare_exchange_weak(currentPeak, threadPeakLive));
+		});
+	}
+	std::thread staller;
+	if(isStalled) staller = std::thread([&](){ scheme.stall(slots[0], stop); });
+
+	auto before = std::chrono::steady_clock::now();
+	start.store(true, std::memory_order_release);
+	std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+	stop.store(true);
+	for(auto& thread : threads) thread.join();
+	if(staller.joinable()) staller.join();
+	auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - before).count();
+
+	std::cout << std::setw(16) << SchemeT::name << std::setw(10) << (isStalled ? "stalled" : "") << std::setw(12) << std::fixed << std::setprecision(2)
+		<< static_cast<double>(totalOperations.load()) / seconds / 1e6 << " M ops/s" << std::setw(12) << peakLive.load() - static_cast<int64_t>(numSlots)
+		<< " peak unreclaimed nodes" << std::endl;
+
+	for(auto& slot : slots) deleteNode(slot.load());
+}
+
+int main(int argc, const char** argv)
+{
+	unsigned numThreads = argc > 1 ? static_cast<unsigned>(std::atoi(argv[1])) : std::max(1u, std::thread::hardware_concurrency());
+	int milliseconds = argc > 2 ? std::atoi(argv[2]) : 1000;
+
+	std::cout << numThreads << " threads, " << numSlots << " slots, one write every " << readsPerWrite << " reads" << std::endl;
+	runBenchmark<HazardPointerScheme>(numThreads, milliseconds, false);
+	runBenchmark<EpochScheme>(numThreads, milliseconds, false);
+	runBenchmark<HazardPointerScheme>(numThreads, milliseconds, true);
+	runBenchmark<EpochScheme>(numThreads, milliseconds, true);
+
+	return 0;
+}
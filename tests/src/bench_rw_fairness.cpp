@@ -0,0 +1,94 @@
+#include "../../src/fts.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <thread>
+#include <vector>
+
+//measures how long every acquisition waits so reader and writer starvation shows up in the tail of the distribution
+//usage: fts_bench_rw_fairness [readers] [writers] [milliseconds]
+
+void busyWork(int iterations)
+{
+	for(int i = 0; i < iterations; i++) std::atomic_signal_fence(std::memory_order_seq_cst);
+}
+
+struct ThreadResult
+{
+	bool isWriter;
+	std::vector<int64_t> waitTimes;
+};
+
+template<typename LockT>
+void worker(LockT* lock, std::atomic_bool* start, std::atomic_bool* stop, ThreadResult* result)
+{
+	while(!start->load(std::memory_order_acquire));
+	while(!stop->load(std::memory_order_relaxed))
+	{
+		auto before = std::chrono::steady_clock::now();
+		if(result->isWriter) lock->writeLock();
+		else lock->readLock();
+		auto after = std::chrono::steady_clock::now();
+		result->waitTimes.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(after - before).count());
+
+		//hold the lock for a short critical section
+		busyWork(200);
+
+		if(result->isWriter) lock->writeUnlock();
+		else lock->readUnlock();
+
+		busyWork(200);
+	}
+}
+
+int64_t percentile(const std::vector<int64_t>& sorted, double p)
+{
+	if(sorted.empty()) return 0;
+	auto index = static_cast<size_t>(p * static_cast<double>(sorted.size() - 1));
+	return sorted[index];
+}
+
+template<typename LockT>
+void runBenchmark(const char* name, int numReaders, int numWriters, int milliseconds)
+{
+	LockT lock;
+	std::atomic_bool start(false);
+	std::atomic_bool stop(false);
+	std::vector<ThreadResult> results(static_cast<size_t>(numReaders + numWriters));
+	std::vector<std::thread> threads;
+	for(size_t i = 0; i < results.size(); i++)
+	{
+		results[i].isWriter = i >= static_cast<size_t>(numReaders);
+		threads.emplace_back(worker<LockT>, &lock, &start, &stop, &results[i]);
+	}
+
+	start.store(true, std::memory_order_release);
+	std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+	stop.store(true);
+	for(auto& t : threads) t.join();
+
+	std::cout << name << " (wait times in ns)" << std::endl;
+	std::cout << std::setw(8) << "thread" << std::setw(8) << "role" << std::setw(14) << "acquisitions"
+		<< std::setw(12) << "p50" << std::setw(12) << "p99" << std::setw(12) << "p99.9" << std::setw(12) << "max" << std::endl;
+	for(size_t i = 0; i < results.size(); i++)
+	{
+		auto& samples = results[i].waitTimes;
+		std::sort(samples.begin(), samples.end());
+		std::cout << std::setw(8) << i << std::setw(8) << (results[i].isWriter ? "writer" : "reader") << std::setw(14) << samples.size()
+			<< std::setw(12) << percentile(samples, 0.5) << std::setw(12) << percentile(samples, 0.99)
+			<< std::setw(12) << percentile(samples, 0.999) << std::setw(12) << (samples.empty() ? 0 : samples.back()) << std::endl;
+	}
+}
+
+int main(int argc, const char** argv)
+{
+	int numReaders = argc > 1 ? std::atoi(argv[1]) : 4;
+	int numWriters = argc > 2 ? std::atoi(argv[2]) : 2;
+	int milliseconds = argc > 3 ? std::atoi(argv[3]) : 500;
+
+	runBenchmark<fts::ReadWriteLock>("ReadWriteLock", numReaders, numWriters, milliseconds);
+	runBenchmark<fts::PhaseFairRWLock>("PhaseFairRWLock", numReaders, numWriters, milliseconds);
+
+	return 0;
+}
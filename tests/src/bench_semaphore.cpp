@@ -0,0 +1,63 @@
+#include "../../src/fts.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <thread>
+#include <vector>
+
+//acquire and release throughput of the sharded semaphore against the spin and adaptive semaphores. There are as many
+//permits as threads so nobody has to wait, what is measured is the cost of every thread updating the count
+//usage: fts_bench_semaphore [threads] [milliseconds]
+
+template<typename SemaphoreT, typename... Args>
+void runBenchmark(const char* name, unsigned numThreads, int milliseconds, Args... args)
+{
+	SemaphoreT semaphore(args...);
+
+	std::atomic_bool start(false);
+	std::atomic_bool stop(false);
+	std::atomic_uint64_t totalOperations(0);
+	std::vector<std::thread> threads;
+	for(unsigned t = 0; t < numThreads; t++)
+	{
+		threads.emplace_back([&]()
+		{
+			uint64_t operations = 0;
+			while(!start.load(std::memory_order_acquire));
+			while(!stop.load(std::memory_order_relaxed))
+			{
+				for(int i = 0; i < 64; i++)
+				{
+					semaphore.lock();
+					semaphore.unlock();
+				}
+				operations += 64;
+			}
+			totalOperations.fetch_add(operations);
+		});
+	}
+
+	auto before = std::chrono::steady_clock::now();
+	start.store(true, std::memory_order_release);
+	std::this_thread::sleep_for(std::chrono::milliseconds(milliseconds));
+	stop.store(true);
+	for(auto& thread : threads) thread.join();
+	auto seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - before).count();
+
+	std::cout << std::setw(20) << name << std::setw(16) << std::fixed << std::setprecision(2)
+		<< static_cast<double>(totalOperations.load()) / seconds / 1e6 << " M acquire/release per s" << std::endl;
+}
+
+int main(int argc, const char** argv)
+{
+	unsigned numThreads = argc > 1 ? static_cast<unsigned>(std::atoi(argv[1])) : std::max(1u, std::thread::hardware_concurrency());
+	int milliseconds = argc > 2 ? std::atoi(argv[2]) : 1000;
+	auto numPermits = static_cast<int32_t>(numThreads);
+
+	std::cout << numThreads << " threads, " << numPermits << " permits" << std::endl;
+	runBenchmark<fts::SpinSemaphore>("SpinSemaphore", numThreads, milliseconds, numPermits);
+	runBenchmark<fts::AdaptiveSemaphore>("AdaptiveSemaphore", numThreads, milliseconds, numPermits);
+	runBenchmark<fts::ShardedSemaphore>("ShardedSemaphore", numThreads, milliseconds, numPermits);
+
+	return 0;
+}
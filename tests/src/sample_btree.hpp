@@ -0,0 +1,414 @@
+#pragma once
+#include "../../src/fts.hpp"
+#include <cstring>
+
+//sample concurrent B+ trees with 64 bit keys and values, no deletion
+//OptimisticBTree uses optimistic lock coupling with fts::OptLock, readers never write to shared memory
+//ReadWriteLockBTree uses classic lock coupling with an fts::ReadWriteLock per node
+namespace sample
+{
+	using Key = uint64_t;
+	using Value = uint64_t;
+
+	enum class NodeType : uint8_t
+	{
+		inner,
+		leaf
+	};
+
+	constexpr size_t pageSize = 4096;
+
+	template<typename LockT>
+	struct NodeBase
+	{
+		LockT lock;
+		NodeType type;
+		uint16_t count = 0;
+	};
+
+	template<typename LockT>
+	struct Leaf : public NodeBase<LockT>
+	{
+		static constexpr size_t maxEntries = (pageSize - sizeof(NodeBase<LockT>)) / (sizeof(Key) + sizeof(Value));
+
+		Key keys[maxEntries];
+		Value values[maxEntries];
+
+		Leaf() { this->type = NodeType::leaf; }
+
+		bool isFull() const { return this->count == maxEntries; }
+
+		size_t lowerBound(Key key) const
+		{
+			size_t lower = 0;
+			size_t upper = this->count;
+			while(lower < upper)
+			{
+				auto middle = (lower + upper) / 2;
+				if(key <= this->keys[middle]) upper = middle;
+				else lower = middle + 1;
+			}
+			return lower;
+		}
+
+		void insert(Key key, Value value)
+		{
+			auto pos = this->lowerBound(key);
+			if(pos < this->count && this->keys[pos] == key)
+			{
+				this->values[pos] = value;
+				return;
+			}
+			std::memmove(this->keys + pos + 1, this->keys + pos, sizeof(Key) * (this->count - pos));
+			std::memmove(this->values + pos + 1, this->values + pos, sizeof(Value) * (this->count - pos));
+			this->keys[pos] = key;
+			this->values[pos] = value;
+			this->count++;
+		}
+
+		//moves the upper half into a new leaf, the separator is the largest key left behind
+		Leaf* split(Key& separator)
+		{
+			auto newLeaf = new Leaf();
+			newLeaf->count = static_cast<uint16_t>(this->count - (this->count / 2));
+			this->count = static_cast<uint16_t>(this->count - newLeaf->count);
+			std::memcpy(newLeaf->keys, this->keys + this->count, sizeof(Key) * newLeaf->count);
+			std::memcpy(newLeaf->values, this->values + this->count, sizeof(Value) * newLeaf->count);
+			separator = this->keys[this->count - 1];
+			return newLeaf;
+		}
+	};
+
+	template<typename LockT>
+	struct Inner : public NodeBase<LockT>
+	{
+		static constexpr size_t maxEntries = (pageSize - sizeof(NodeBase<LockT>)) / (sizeof(Key) + sizeof(NodeBase<LockT>*));
+
+		//count keys separate count + 1 children, keys[i] is the largest key below children[i]
+		NodeBase<LockT>* children[maxEntries];
+		Key keys[maxEntries];
+
+		Inner() { this->type = NodeType::inner; }
+
+		bool isFull() const { return this->count == maxEntries - 1; }
+
+		size_t lowerBound(Key key) const
+		{
+			size_t lower = 0;
+			size_t upper = this->count;
+			while(lower < upper)
+			{
+				auto middle = (lower + upper) / 2;
+				if(key <= this->keys[middle]) upper = middle;
+				else lower = middle + 1;
+			}
+			return lower;
+		}
+
+		void insert(Key key, NodeBase<LockT>* child)
+		{
+			auto pos = this->lowerBound(key);
+			std::memmove(this->keys + pos + 1, this->keys + pos, sizeof(Key) * (this->count - pos + 1));
+			std::memmove(this->children + pos + 1, this->children + pos, sizeof(NodeBase<LockT>*) * (this->count - pos + 1));
+			this->keys[pos] = key;
+			this->children[pos] = child;
+			std::swap(this->children[pos], this->children[pos + 1]);
+			this->count++;
+		}
+
+		Inner* split(Key& separator)
+		{
+			auto newInner = new Inner();
+			newInner->count = static_cast<uint16_t>(this->count - (this->count / 2));
+			this->count = static_cast<uint16_t>(this->count - newInner->count - 1);
+			separator = this->keys[this->count];
+			std::memcpy(newInner->keys, this->keys + this->count + 1, sizeof(Key) * (newInner->count + 1));
+			std::memcpy(newInner->children, this->children + this->count + 1, sizeof(NodeBase<LockT>*) * (newInner->count + 1));
+			return newInner;
+		}
+	};
+
+	template<typename LockT>
+	bool isFull(NodeBase<LockT>* node)
+	{
+		if(node->type == NodeType::leaf) return static_cast<Leaf<LockT>*>(node)->isFull();
+		else return static_cast<Inner<LockT>*>(node)->isFull();
+	}
+
+	template<typename LockT>
+	NodeBase<LockT>* split(NodeBase<LockT>* node, Key& separator)
+	{
+		if(node->type == NodeType::leaf) return static_cast<Leaf<LockT>*>(node)->split(separator);
+		else return static_cast<Inner<LockT>*>(node)->split(separator);
+	}
+
+	template<typename LockT>
+	void destroy(NodeBase<LockT>* node)
+	{
+		if(node->type == NodeType::inner)
+		{
+			auto inner = static_cast<Inner<LockT>*>(node);
+			for(size_t i = 0; i <= inner->count; i++) destroy(inner->children[i]);
+			delete inner;
+		}
+		else
+		{
+			delete static_cast<Leaf<LockT>*>(node);
+		}
+	}
+
+	class OptimisticBTree
+	{
+		public:
+			using NodeT = NodeBase<fts::OptLock>;
+			using LeafT = Leaf<fts::OptLock>;
+			using InnerT = Inner<fts::OptLock>;
+
+			OptimisticBTree() : m_root(new LeafT()) {}
+			OptimisticBTree(const OptimisticBTree&) = delete;
+			~OptimisticBTree() { destroy(this->m_root.load()); }
+
+			OptimisticBTree& operator=(const OptimisticBTree&) = delete;
+
+			void insert(Key key, Value value)
+			{
+				while(!this->tryInsert(key, value));
+			}
+			bool lookup(Key key, Value& result) const
+			{
+				while(true)
+				{
+					bool needRestart = false;
+					auto found = this->tryLookup(key, result, needRestart);
+					if(!needRestart) return found;
+				}
+			}
+
+		private:
+			void makeRoot(Key separator, NodeT* left, NodeT* right)
+			{
+				auto inner = new InnerT();
+				inner->count = 1;
+				inner->keys[0] = separator;
+				inner->children[0] = left;
+				inner->children[1] = right;
+				this->m_root.store(inner);
+			}
+
+			//splits a full node, both the node and its parent (if any) are write locked by the caller
+			void splitNode(NodeT* node, InnerT* parent)
+			{
+				Key separator;
+				auto newNode = split(node, separator);
+				if(parent) parent->insert(separator, newNode);
+				else this->makeRoot(separator, node, newNode);
+			}
+
+			//returns false when the traversal has to restart
+			bool tryInsert(Key key, Value value)
+			{
+				bool needRestart = false;
+				NodeT* node = this->m_root.load();
+				auto versionNode = node->lock.readLockOrRestart(needRestart);
+				if(needRestart || node != this->m_root.load()) return false;
+
+				InnerT* parent = nullptr;
+				uint64_t versionParent = 0;
+
+				while(true)
+				{
+					if(isFull(node))
+					{
+						//split on the way down so the parent always has room for the separator
+						if(parent)
+						{
+							parent->lock.upgradeToWriteLockOrRestart(versionParent, needRestart);
+							if(needRestart) return false;
+						}
+						node->lock.upgradeToWriteLockOrRestart(versionNode, needRestart);
+						if(needRestart)
+						{
+							if(parent) parent->lock.writeUnlock();
+							return false;
+						}
+						if(!parent && node != this->m_root.load())
+						{
+							node->lock.writeUnlock();
+							return false;
+						}
+						this->splitNode(node, parent);
+						node->lock.writeUnlock();
+						if(parent) parent->lock.writeUnlock();
+						return false;
+					}
+
+					if(node->type == NodeType::leaf) break;
+
+					if(parent)
+					{
+						parent->lock.readUnlockOrRestart(versionParent, needRestart);
+						if(needRestart) return false;
+					}
+					parent = static_cast<InnerT*>(node);
+					versionParent = versionNode;
+
+					node = parent->children[parent->lowerBound(key)];
+					parent->lock.checkOrRestart(versionParent, needRestart);
+					if(needRestart) return false;
+					versionNode = node->lock.readLockOrRestart(needRestart);
+					if(needRestart) return false;
+				}
+
+				node->lock.upgradeToWriteLockOrRestart(versionNode, needRestart);
+				if(needRestart) return false;
+				if(parent)
+				{
+					parent->lock.readUnlockOrRestart(versionParent, needRestart);
+					if(needRestart)
+					{
+						node->lock.writeUnlock();
+						return false;
+					}
+				}
+				static_cast<LeafT*>(node)->insert(key, value);
+				node->lock.writeUnlock();
+				return true;
+			}
+
+			bool tryLookup(Key key, Value& result, bool& needRestart) const
+			{
+				NodeT* node = this->m_root.load();
+				auto versionNode = node->lock.readLockOrRestart(needRestart);
+				if(needRestart || node != this->m_root.load())
+				{
+					needRestart = true;
+					return false;
+				}
+
+				InnerT* parent = nullptr;
+				uint64_t versionParent = 0;
+
+				while(node->type == NodeType::inner)
+				{
+					if(parent)
+					{
+						parent->lock.readUnlockOrRestart(versionParent, needRestart);
+						if(needRestart) return false;
+					}
+					parent = static_cast<InnerT*>(node);
+					versionParent = versionNode;
+
+					node = parent->children[parent->lowerBound(key)];
+					parent->lock.checkOrRestart(versionParent, needRestart);
+					if(needRestart) return false;
+					versionNode = node->lock.readLockOrRestart(needRestart);
+					if(needRestart) return false;
+				}
+
+				auto leaf = static_cast<LeafT*>(node);
+				auto pos = leaf->lowerBound(key);
+				auto found = pos < leaf->count && leaf->keys[pos] == key;
+				if(found) result = leaf->values[pos];
+
+				if(parent)
+				{
+					parent->lock.readUnlockOrRestart(versionParent, needRestart);
+					if(needRestart) return false;
+				}
+				node->lock.readUnlockOrRestart(versionNode, needRestart);
+				return found;
+			}
+
+			std::atomic<NodeT*> m_root;
+	};
+
+	class ReadWriteLockBTree
+	{
+		public:
+			using NodeT = NodeBase<fts::ReadWriteLock>;
+			using LeafT = Leaf<fts::ReadWriteLock>;
+			using InnerT = Inner<fts::ReadWriteLock>;
+
+			ReadWriteLockBTree() : m_root(new LeafT()) {}
+			ReadWriteLockBTree(const ReadWriteLockBTree&) = delete;
+			~ReadWriteLockBTree() { destroy(this->m_root); }
+
+			ReadWriteLockBTree& operator=(const ReadWriteLockBTree&) = delete;
+
+			void insert(Key key, Value value)
+			{
+				//m_rootLock acts as the parent of the root node
+				this->m_rootLock.writeLock();
+				NodeT* node = this->m_root;
+				node->lock.writeLock();
+				InnerT* parent = nullptr;
+
+				while(true)
+				{
+					if(isFull(node))
+					{
+						Key separator;
+						auto newNode = split(node, separator);
+						if(parent) parent->insert(separator, newNode);
+						else this->makeRoot(separator, node, newNode);
+						//the new node is only reachable through the still locked parent
+						if(key > separator)
+						{
+							newNode->lock.writeLock();
+							node->lock.writeUnlock();
+							node = newNode;
+						}
+					}
+
+					//node cannot split any more so its parent can be released
+					if(parent) parent->lock.writeUnlock();
+					else this->m_rootLock.writeUnlock();
+
+					if(node->type == NodeType::leaf) break;
+
+					parent = static_cast<InnerT*>(node);
+					node = parent->children[parent->lowerBound(key)];
+					node->lock.writeLock();
+				}
+
+				static_cast<LeafT*>(node)->insert(key, value);
+				node->lock.writeUnlock();
+			}
+			bool lookup(Key key, Value& result)
+			{
+				this->m_rootLock.readLock();
+				NodeT* node = this->m_root;
+				node->lock.readLock();
+				this->m_rootLock.readUnlock();
+
+				while(node->type == NodeType::inner)
+				{
+					auto inner = static_cast<InnerT*>(node);
+					node = inner->children[inner->lowerBound(key)];
+					node->lock.readLock();
+					inner->lock.readUnlock();
+				}
+
+				auto leaf = static_cast<LeafT*>(node);
+				auto pos = leaf->lowerBound(key);
+				auto found = pos < leaf->count && leaf->keys[pos] == key;
+				if(found) result = leaf->values[pos];
+				leaf->lock.readUnlock();
+				return found;
+			}
+
+		private:
+			void makeRoot(Key separator, NodeT* left, NodeT* right)
+			{
+				auto inner = new InnerT();
+				inner->count = 1;
+				inner->keys[0] = separator;
+				inner->children[0] = left;
+				inner->children[1] = right;
+				this->m_root = inner;
+			}
+
+			fts::ReadWriteLock m_rootLock;
+			NodeT* m_root;
+	};
+}